@@ -0,0 +1,427 @@
+// Headless benchmark of the enemy path finding and turns on generated levels, no window or GL context.
+// Prints the results as JSON. See --help for the options.
+// With --check it instead compares the path finding algorithms on every shipped level (reading data/ from the working
+// directory like the game) and exits non-zero if they disagree.
+
+// internal
+#include "ai.hpp"
+#include "baseline_bfs.hpp"
+#include "bench_common.hpp"
+#include "common.hpp"
+#include "crawl_clusters.hpp"
+#include "crawl_graph.hpp"
+#include "physics.hpp"
+#include "profiler.hpp"
+#include "render_components.hpp"
+#include "snail.hpp"
+#include "spider.hpp"
+#include "tiles/tiles.hpp"
+#include "tiny_ecs.hpp"
+#include "visibility.hpp"
+
+// stlib
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using json = nlohmann::json;
+
+struct Options
+{
+	int rows = 40;
+	int columns = 120;
+	float wallDensity = 0.3f;
+	int enemies = 20;
+	int queries = 500;
+	int turns = 200;
+	int thinkMs = 5;
+	unsigned int seed = 1;
+	std::string out;
+	bool check = false;
+};
+
+static const float SCALE = 50.f;
+static const vec2 WINDOW_SIZE = { 1200, 800 };
+// how far away a spider notices the snail, in tiles (isSnailInRange in ai.cpp)
+static const int SPIDER_RANGE = 7;
+
+static bool parseOptions(int argc, char* argv[], Options& options)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		if (arg == "--check")
+		{
+			options.check = true;
+			continue;
+		}
+		if (arg == "--help" || i + 1 >= argc)
+			return false;
+		std::string value = argv[++i];
+		if (arg == "--rows")
+			options.rows = std::stoi(value);
+		else if (arg == "--columns")
+			options.columns = std::stoi(value);
+		else if (arg == "--walls")
+			options.wallDensity = std::stof(value);
+		else if (arg == "--enemies")
+			options.enemies = std::stoi(value);
+		else if (arg == "--queries")
+			options.queries = std::stoi(value);
+		else if (arg == "--turns")
+			options.turns = std::stoi(value);
+		else if (arg == "--think-ms")
+			options.thinkMs = std::stoi(value);
+		else if (arg == "--seed")
+			options.seed = static_cast<unsigned int>(std::stoul(value));
+		else if (arg == "--out")
+			options.out = value;
+		else
+			return false;
+	}
+	return options.rows >= 3 && options.columns >= 3 && options.wallDensity >= 0.f && options.wallDensity < 1.f;
+}
+
+static vec2 tileCentre(ivec2 tile)
+{
+	return { (tile.y + 0.5f) * SCALE, (tile.x + 0.5f) * SCALE };
+}
+
+// Fills the tile grid with walls around the edge and at random inside, and builds everything the AI reads from it.
+// Gives the tiles of the largest part of the level the characters can crawl around in.
+static std::vector<ivec2> generateLevel(const Options& options, std::mt19937& random)
+{
+	TileSystem::resetGrid();
+	TileSystem::setScale(SCALE);
+	std::bernoulli_distribution wall(options.wallDensity);
+	auto& tiles = TileSystem::getTiles();
+	for (int row = 0; row < options.rows; row++)
+	{
+		std::vector<Tile> tileRow;
+		for (int col = 0; col < options.columns; col++)
+		{
+			Tile tile;
+			vec2 centre = tileCentre({ row, col });
+			tile.x = centre.x;
+			tile.y = centre.y;
+			bool edge = row == 0 || col == 0 || row == options.rows - 1 || col == options.columns - 1;
+			tile.type = edge || wall(random) ? WALL : EMPTY;
+			tileRow.push_back(tile);
+		}
+		tiles.push_back(tileRow);
+	}
+	TileSystem::rebuildTileMovesMap();
+	TileSystem::rebuildTileMovesGrid();
+	CrawlGraph::build();
+	Visibility::build();
+	CrawlClusters::build();
+
+	// the crawl moves go both ways, so a search from any tile finds its whole part of the level
+	int tileCount = CrawlGraph::rows() * CrawlGraph::columns();
+	std::vector<int> part(tileCount, -1);
+	std::vector<int> largest;
+	for (int tile = 0; tile < tileCount; tile++)
+	{
+		if (part[tile] >= 0 || CrawlGraph::movesFrom(tile).begin() == CrawlGraph::movesFrom(tile).end())
+			continue;
+		std::vector<int> reached = { tile };
+		part[tile] = tile;
+		for (size_t i = 0; i < reached.size(); i++)
+		{
+			for (const auto& move : CrawlGraph::movesFrom(reached[i]))
+			{
+				if (part[move.to] < 0)
+				{
+					part[move.to] = tile;
+					reached.push_back(move.to);
+				}
+			}
+		}
+		if (reached.size() > largest.size())
+			largest.swap(reached);
+	}
+	std::vector<ivec2> crawlable;
+	for (int tile : largest)
+		crawlable.push_back(CrawlGraph::tile(tile));
+	return crawlable;
+}
+
+// Places the tiles of a shipped level like LevelLoader does, without creating any of the entities on them.
+// Gives the tiles characters can crawl on.
+static std::vector<ivec2> loadLevelTiles(const std::string& name)
+{
+	std::ifstream file(levels_path(name));
+	json level = json::parse(file);
+	float scale = level["scale"];
+	TileSystem::resetGrid();
+	TileSystem::setScale(scale);
+	auto& tiles = TileSystem::getTiles();
+	for (int row = 0; row < static_cast<int>(level["tiles"].size()); row++)
+	{
+		std::string types = level["tiles"][row];
+		std::vector<Tile> tileRow;
+		for (int col = 0; col < static_cast<int>(types.size()); col++)
+		{
+			Tile tile;
+			tile.x = (col + 0.5f) * scale;
+			tile.y = (row + 0.5f) * scale;
+			switch (types[col])
+			{
+			case 'X': tile.type = WALL; break;
+			case 'W': tile.type = WATER; break;
+			case 'V': tile.type = VINE; break;
+			case 'N': tile.type = INACCESSIBLE; break;
+			case 'M': tile.type = MESSAGE; break;
+			default: tile.type = EMPTY; break;
+			}
+			tileRow.push_back(tile);
+		}
+		tiles.push_back(tileRow);
+	}
+	TileSystem::rebuildTileMovesMap();
+	TileSystem::rebuildTileMovesGrid();
+	CrawlGraph::build();
+	Visibility::build();
+	CrawlClusters::build();
+
+	std::vector<ivec2> crawlable;
+	for (const auto& entry : TileSystem::getAllTileMovesMap())
+		crawlable.push_back(entry.first);
+	// the map's order isn't the same everywhere
+	std::sort(crawlable.begin(), crawlable.end(), [](ivec2 a, ivec2 b) { return a.x != b.x ? a.x < b.x : a.y < b.y; });
+	return crawlable;
+}
+
+static std::string describe(const std::vector<vec2>& path)
+{
+	std::string text;
+	for (vec2 tile : path)
+		text += "(" + std::to_string(static_cast<int>(tile.x)) + "," + std::to_string(static_cast<int>(tile.y)) + ")";
+	return text;
+}
+
+// Between every pair of crawlable tiles of every shipped level: the BFS finds the same path as the BFS it replaced, and
+// JPS finds a path as long as the one of A* (both are shortest, but may take different ones of the same length)
+static int checkLevels()
+{
+	for (const std::string& name : levels)
+	{
+		std::vector<ivec2> crawlable = loadLevelTiles(name);
+		int pairs = 0;
+		int bfsMismatches = 0;
+		int jpsMismatches = 0;
+		for (ivec2 start : crawlable)
+		{
+			for (ivec2 goal : crawlable)
+			{
+				if (start == goal)
+					continue;
+				pairs++;
+				std::vector<vec2> bfs = AISystem::shortestPathBFS(vec2(start), vec2(goal), "spider");
+				std::vector<vec2> baseline = BaselineBFS::shortestPath(vec2(start), vec2(goal));
+				if (bfs != baseline && bfsMismatches++ == 0)
+					std::cerr << name << ": BFS " << describe(bfs) << ", baseline BFS " << describe(baseline) << std::endl;
+
+				std::vector<vec2> aStar = AISystem::shortestPathAStar(vec2(start), vec2(goal), "spider");
+				std::vector<vec2> jps = AISystem::shortestPathJPS(vec2(start), vec2(goal), "spider");
+				if (jps.size() != aStar.size() && jpsMismatches++ == 0)
+					std::cerr << name << ": JPS " << describe(jps) << ", A* " << describe(aStar) << std::endl;
+			}
+		}
+		std::string between = " between " + std::to_string(pairs) + " pairs of tiles";
+		Bench::check(bfsMismatches == 0, name + ": BFS finds the paths of the baseline BFS" + between);
+		Bench::check(jpsMismatches == 0, name + ": JPS paths are as long as the A* paths" + between);
+	}
+	return Bench::checkResult();
+}
+
+typedef std::vector<vec2> (*PathQuery)(vec2 start, vec2 goal, std::string animal);
+
+// the same start and goal pairs for every algorithm
+static json benchmarkQueries(PathQuery query, const std::vector<std::pair<ivec2, ivec2>>& pairs)
+{
+	Bench::Samples samples;
+	for (const auto& pair : pairs)
+	{
+		long long allocated = Bench::allocations();
+		auto begin = std::chrono::high_resolution_clock::now();
+		std::vector<vec2> path = query(vec2(pair.first), vec2(pair.second), "spider");
+		auto end = std::chrono::high_resolution_clock::now();
+		double allocations = static_cast<double>(Bench::allocations() - allocated);
+		samples.microseconds.push_back(std::chrono::duration<double, std::micro>(end - begin).count());
+		samples.allocations.push_back(allocations);
+		samples.expanded.push_back(AISystem::pathStats.expanded);
+	}
+	return Bench::report(samples);
+}
+
+// an entity moving from one tile to another, through the same occupancy update the physics uses
+static void moveTo(Motion& motion, vec2 position)
+{
+	UpdateTileOccupancy(motion.position, position);
+	motion.position = position;
+}
+
+// Whole enemy turns of AISystem::step with spiders chasing a snail that wanders around the level. The spiders start
+// within range of the snail, where they look for a path to it. Slugs would fire, and the projectiles need meshes, so
+// they are left out. The player takes thinkMs to decide, which is when the speculation runs. Turns in which no enemy
+// looked for a path don't measure the path finding, they are counted but not timed.
+static json benchmarkTurns(const std::string& algorithm, const Options& options)
+{
+	std::mt19937 random(options.seed);
+	ECS::ContainerInterface::clear_all_components();
+	std::vector<ivec2> crawlable = generateLevel(options, random);
+	if (crawlable.empty())
+		return json::object();
+	std::uniform_int_distribution<size_t> anyTile(0, crawlable.size() - 1);
+	AISystem::aiPathFindingAlgorithm = algorithm;
+	AISystem::aiMoved = false;
+	auto& tiles = TileSystem::getTiles();
+
+	Camera::reset();
+	ECS::Entity turnEntity;
+	ECS::registry<Turn>.emplace(turnEntity).type = PLAYER_WAITING;
+	ECS::Entity snail;
+	ECS::registry<Snail>.emplace(snail);
+	ivec2 snailTile = crawlable[anyTile(random)];
+	ECS::registry<Motion>.emplace(snail).position = tileCentre(snailTile);
+	tiles[snailTile.x][snailTile.y].addOccupyingEntity();
+	std::vector<ivec2> inRange;
+	for (ivec2 tile : crawlable)
+	{
+		if (tile != snailTile && Visibility::inRange(tile, snailTile, SPIDER_RANGE))
+			inRange.push_back(tile);
+	}
+	if (inRange.empty())
+		return json::object();
+	std::uniform_int_distribution<size_t> anyTileInRange(0, inRange.size() - 1);
+	for (int i = 0; i < options.enemies; i++)
+	{
+		ECS::Entity entity;
+		ivec2 tile = inRange[anyTileInRange(random)];
+		auto& motion = ECS::registry<Motion>.emplace(entity);
+		motion.position = tileCentre(tile);
+		motion.lastDirection = DIRECTION_WEST;
+		tiles[tile.x][tile.y].addOccupyingEntity();
+		ECS::registry<Enemy>.emplace(entity);
+		ECS::registry<Spider>.emplace(entity);
+		ECS::registry<DirectionInput>.emplace(entity);
+		auto& ai = ECS::registry<AI>.emplace(entity);
+		ai.tree = &BTDefinition::spider();
+		ai.instance = ai.tree->start(entity);
+	}
+
+	// the whole turn in one step, it is the total that is measured
+	float budget = AISystem::frameBudgetMicroseconds;
+	AISystem::frameBudgetMicroseconds = std::numeric_limits<float>::max();
+	AISystem ai;
+	Bench::Samples samples;
+	FrameStats totals;
+	int withoutQueries = 0;
+	for (int turn = 0; turn < options.turns; turn++)
+	{
+		// the player decides, the snail moves, then the enemies get their turn
+		auto& turnType = ECS::registry<Turn>.get(turnEntity).type;
+		turnType = PLAYER_WAITING;
+		ai.step(0.f, WINDOW_SIZE);
+		std::this_thread::sleep_for(std::chrono::milliseconds(options.thinkMs));
+		auto& snailMotion = ECS::registry<Motion>.get(snail);
+		int snailIndex = CrawlGraph::index(static_cast<int>(snailMotion.position.y / SCALE), static_cast<int>(snailMotion.position.x / SCALE));
+		auto moves = CrawlGraph::movesFrom(snailIndex);
+		if (moves.begin() != moves.end())
+			moveTo(snailMotion, tileCentre(CrawlGraph::tile(moves.first[random() % (moves.last - moves.first)].to)));
+
+		turnType = ENEMY;
+		AISystem::aiMoved = false;
+		Profiler::frame = FrameStats();
+		long long allocated = Bench::allocations();
+		auto begin = std::chrono::high_resolution_clock::now();
+		ai.step(0.f, WINDOW_SIZE);
+		auto end = std::chrono::high_resolution_clock::now();
+		double allocations = static_cast<double>(Bench::allocations() - allocated);
+		const FrameStats& frame = Profiler::frame;
+		if (frame.pathCacheHits + frame.pathCacheRepairs + frame.pathCacheMisses == 0)
+		{
+			withoutQueries++;
+		}
+		else
+		{
+			samples.microseconds.push_back(std::chrono::duration<double, std::micro>(end - begin).count());
+			samples.allocations.push_back(allocations);
+		}
+		totals.aiTicks += frame.aiTicks;
+		totals.pathCacheHits += frame.pathCacheHits;
+		totals.pathCacheRepairs += frame.pathCacheRepairs;
+		totals.pathCacheMisses += frame.pathCacheMisses;
+		totals.fieldsSpeculated += frame.fieldsSpeculated;
+		totals.fieldsComputed += frame.fieldsComputed;
+
+		// where physics would take the enemies by the next turn
+		for (auto entity : ECS::registry<Destination>.entities)
+		{
+			auto& motion = ECS::registry<Motion>.get(entity);
+			moveTo(motion, ECS::registry<Destination>.get(entity).position);
+			motion.velocity = { 0.f, 0.f };
+		}
+		ECS::registry<Destination>.clear();
+	}
+	AISystem::frameBudgetMicroseconds = budget;
+
+	json result = Bench::report(samples);
+	result["enemy_ticks"] = totals.aiTicks;
+	result["turns_without_path_queries"] = withoutQueries;
+	result["path_cache"] = { { "hits", totals.pathCacheHits }, { "repairs", totals.pathCacheRepairs }, { "misses", totals.pathCacheMisses } };
+	result["snail_fields"] = { { "speculated", totals.fieldsSpeculated }, { "computed", totals.fieldsComputed } };
+	return result;
+}
+
+int main(int argc, char* argv[])
+{
+	Options options;
+	if (!parseOptions(argc, argv, options))
+	{
+		std::cerr << "usage: ai_bench [--rows N] [--columns N] [--walls DENSITY] [--enemies N] [--queries N] [--turns N] "
+			"[--think-ms N] [--seed N] [--out FILE]" << std::endl;
+		std::cerr << "       ai_bench --check" << std::endl;
+		return 1;
+	}
+	if (options.check)
+		return checkLevels();
+
+	std::mt19937 random(options.seed);
+	std::vector<ivec2> crawlable = generateLevel(options, random);
+	if (crawlable.empty())
+	{
+		std::cerr << "the generated level has no tiles to crawl on, try fewer walls" << std::endl;
+		return 1;
+	}
+	std::uniform_int_distribution<size_t> anyTile(0, crawlable.size() - 1);
+	std::vector<std::pair<ivec2, ivec2>> pairs;
+	for (int i = 0; i < options.queries; i++)
+		pairs.push_back({ crawlable[anyTile(random)], crawlable[anyTile(random)] });
+
+	json results;
+	results["level"] = {
+		{ "rows", options.rows },
+		{ "columns", options.columns },
+		{ "wall_density", options.wallDensity },
+		{ "crawlable_tiles", crawlable.size() },
+		{ "enemies", options.enemies },
+		{ "seed", options.seed },
+	};
+	results["queries"][AI_PF_ALGO_BFS] = benchmarkQueries(AISystem::shortestPathBFS, pairs);
+	results["queries"][AI_PF_ALGO_A_STAR] = benchmarkQueries(AISystem::shortestPathAStar, pairs);
+	results["queries"][AI_PF_ALGO_JPS] = benchmarkQueries(AISystem::shortestPathJPS, pairs);
+	results["queries"][AI_PF_ALGO_HPA] = benchmarkQueries(AISystem::shortestPathHPA, pairs);
+	for (const char* algorithm : { AI_PF_ALGO_BFS, AI_PF_ALGO_A_STAR, AI_PF_ALGO_JPS, AI_PF_ALGO_HPA, AI_PF_ALGO_DISTANCE_FIELD })
+		results["turns"][algorithm] = benchmarkTurns(algorithm, options);
+
+	Bench::write(results, options.out);
+	return 0;
+}
@@ -0,0 +1,135 @@
+// header
+#include "baseline_bfs.hpp"
+#include "tiles/tiles.hpp"
+
+// stlib
+#include <deque>
+
+// The moves are the ones of AISystem::checkIfReachedDestinationOrAddNeighboringNodesToFrontier before the crawl graph,
+// rule for rule, without the debug drawing. The tiles are read through tileType instead of indexing the grid, which read
+// past the edge of the grid for tiles on it.
+
+// type of the tile at (row, column), INACCESSIBLE outside of the grid
+static TYPE tileType(int row, int col)
+{
+	auto& tiles = TileSystem::getTiles();
+	if (row < 0 || row >= static_cast<int>(tiles.size()) || col < 0 || col >= static_cast<int>(tiles[row].size()))
+		return INACCESSIBLE;
+	return tiles[row][col].type;
+}
+
+static bool reachedGoalOrAddNeighbours(std::deque<std::vector<vec2>>& frontier, std::vector<vec2>& current,
+	TileSystem::vec2Map& tileMovesMap, vec2 goal)
+{
+	if (current[current.size() - 1] == goal)
+		return true;
+
+	vec2 endNode = current[current.size() - 1];
+	int x = static_cast<int>(endNode.x);
+	int y = static_cast<int>(endNode.y);
+	std::vector<vec2> next = current;
+	auto canMoveTo = [&tileMovesMap](int row, int col) { return tileMovesMap.find({ row, col }) != tileMovesMap.end(); };
+	// adds the path through the given tiles to the frontier and erases the erased tile from the moves map
+	auto push = [&](std::vector<vec2> tiles, ivec2 erased)
+	{
+		next.insert(next.end(), tiles.begin(), tiles.end());
+		frontier.push_back(next);
+		next = current;
+		tileMovesMap.erase(erased);
+	};
+
+	// wall above
+	if (tileType(x-1, y) == WALL) {
+		if (canMoveTo(x-1, y-1) && tileType(x, y-1) == EMPTY)
+			push({ {x, y-1}, {x-1, y-1} }, {x-1, y-1});
+		if (canMoveTo(x-1, y+1) && tileType(x, y+1) == EMPTY)
+			push({ {x, y+1}, {x-1, y+1} }, {x-1, y+1});
+		// left tile
+		if (canMoveTo(x, y-1) && tileType(x-1, y-1) == WALL)
+			push({ {x, y-1} }, {x, y-1});
+		// right tile
+		if (canMoveTo(x, y+1) && tileType(x-1, y+1) == WALL)
+			push({ {x, y+1} }, {x, y+1});
+	}
+	// wall on the right
+	if (tileType(x, y+1) == WALL) {
+		if (canMoveTo(x+1, y+1) && tileType(x+1, y) == EMPTY)
+			push({ {x+1, y}, {x+1, y+1} }, {x+1, y+1});
+		if (canMoveTo(x-1, y+1) && tileType(x-1, y) == EMPTY)
+			push({ {x-1, y}, {x-1, y+1} }, {x-1, y+1});
+		// up tile
+		if (canMoveTo(x-1, y) && tileType(x-1, y+1) == WALL)
+			push({ {x-1, y} }, {x-1, y});
+		// down tile
+		if (canMoveTo(x+1, y) && tileType(x+1, y+1) == WALL)
+			push({ {x+1, y} }, {x+1, y});
+	}
+	// wall on the left
+	if (tileType(x, y-1) == WALL) {
+		if (canMoveTo(x-1, y-1) && tileType(x-1, y) == EMPTY)
+			push({ {x-1, y}, {x-1, y-1} }, {x-1, y-1});
+		if (canMoveTo(x+1, y-1) && tileType(x+1, y) == EMPTY)
+			push({ {x+1, y}, {x+1, y-1} }, {x+1, y-1});
+		// up tile
+		if (canMoveTo(x-1, y) && tileType(x-1, y-1) == WALL)
+			push({ {x-1, y} }, {x-1, y});
+		// down tile
+		if (canMoveTo(x+1, y) && tileType(x+1, y-1) == WALL)
+			push({ {x+1, y} }, {x+1, y});
+	}
+	// wall below
+	if (tileType(x+1, y) == WALL) {
+		// erases the tile on the other side, as it always did
+		if (canMoveTo(x+1, y+1) && tileType(x, y+1) == EMPTY)
+			push({ {x, y+1}, {x+1, y+1} }, {x+1, y-1});
+		if (canMoveTo(x+1, y-1) && tileType(x, y-1) == EMPTY)
+			push({ {x, y-1}, {x+1, y-1} }, {x+1, y-1});
+		// left tile
+		if (canMoveTo(x, y-1) && tileType(x+1, y-1) == WALL)
+			push({ {x, y-1} }, {x, y-1});
+		// right tile
+		if (canMoveTo(x, y+1) && tileType(x+1, y+1) == WALL)
+			push({ {x, y+1} }, {x, y+1});
+	}
+
+	// onto a vine
+	if (canMoveTo(x, y-1) && tileType(x, y-1) == VINE)
+		push({ {x, y-1} }, {x, y-1});
+	if (canMoveTo(x, y+1) && tileType(x, y+1) == VINE)
+		push({ {x, y+1} }, {x, y+1});
+	if (canMoveTo(x-1, y) && tileType(x-1, y) == VINE)
+		push({ {x-1, y} }, {x-1, y});
+	if (canMoveTo(x+1, y) && tileType(x+1, y) == VINE)
+		push({ {x+1, y} }, {x+1, y});
+
+	// off the current vine, along a wall
+	bool onVine = tileType(x, y) == VINE;
+	if (canMoveTo(x, y-1) && onVine && (tileType(x+1, y-1) == WALL || tileType(x-1, y-1) == WALL))
+		push({ {x, y-1} }, {x, y-1});
+	if (canMoveTo(x, y+1) && onVine && (tileType(x-1, y+1) == WALL || tileType(x+1, y+1) == WALL))
+		push({ {x, y+1} }, {x, y+1});
+	if (canMoveTo(x-1, y) && onVine && (tileType(x-1, y-1) == WALL || tileType(x-1, y+1) == WALL))
+		push({ {x-1, y} }, {x-1, y});
+	if (canMoveTo(x+1, y) && onVine && (tileType(x+1, y-1) == WALL || tileType(x+1, y+1) == WALL))
+		push({ {x+1, y} }, {x+1, y});
+	return false;
+}
+
+std::vector<vec2> BaselineBFS::shortestPath(vec2 start, vec2 goal)
+{
+	auto tileMovesMap = TileSystem::getAllTileMovesMap();
+	std::vector<vec2> startFrontier;
+	startFrontier.push_back(start);
+	tileMovesMap.erase(start);
+	std::deque<std::vector<vec2>> frontier = { startFrontier };
+	std::vector<vec2> current = frontier.front();
+
+	while (!frontier.empty())
+	{
+		current = frontier.front();
+		frontier.pop_front();
+		if (reachedGoalOrAddNeighbours(frontier, current, tileMovesMap, goal))
+			return current;
+	}
+	return startFrontier;
+}
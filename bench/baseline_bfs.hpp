@@ -0,0 +1,17 @@
+#pragma once
+
+// internal
+#include "common.hpp"
+
+// stlib
+#include <vector>
+
+// The enemy BFS as it was before it ran over the crawl graph: paths copied into a deque of paths and visited tiles erased
+// from a copy of the moves map. Kept for ai_bench to check the current BFS still finds the same paths.
+class BaselineBFS
+{
+public:
+	// path of (row, column) tiles from start to goal, including the tiles passed going around corners, just the start if
+	// the goal can't be reached
+	static std::vector<vec2> shortestPath(vec2 start, vec2 goal);
+};
@@ -0,0 +1,108 @@
+// header
+#include "bench_common.hpp"
+
+// stlib
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <new>
+
+// the GL loader lives in main.cpp, which isn't part of the benchmarks. Last, since on Linux it brings in the X11
+// headers and their macros. Nothing here calls GL.
+#define GL3W_IMPLEMENTATION
+#include <gl3w.h>
+
+static std::atomic<long long> allocationCount(0);
+
+// gcc sees the operators below inlined and takes the pointers from operator new being freed for a mismatch
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void* operator new(std::size_t size)
+{
+	allocationCount++;
+	if (void* memory = std::malloc(size == 0 ? 1 : size))
+		return memory;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept
+{
+	std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+	std::free(memory);
+}
+
+int Bench::failedChecks = 0;
+
+long long Bench::allocations()
+{
+	return allocationCount;
+}
+
+double Bench::percentile(std::vector<double> values, double fraction)
+{
+	if (values.empty())
+		return 0.0;
+	std::sort(values.begin(), values.end());
+	size_t at = std::min(values.size() - 1, static_cast<size_t>(fraction * values.size()));
+	return values[at];
+}
+
+double Bench::mean(const std::vector<double>& values)
+{
+	if (values.empty())
+		return 0.0;
+	double sum = 0.0;
+	for (double value : values)
+		sum += value;
+	return sum / values.size();
+}
+
+nlohmann::json Bench::report(const Samples& samples)
+{
+	nlohmann::json result = {
+		{ "samples", samples.microseconds.size() },
+		{ "p50_us", percentile(samples.microseconds, 0.5) },
+		{ "p99_us", percentile(samples.microseconds, 0.99) },
+		{ "mean_us", mean(samples.microseconds) },
+		{ "allocations_mean", mean(samples.allocations) },
+	};
+	if (!samples.expanded.empty())
+	{
+		result["nodes_expanded_mean"] = mean(samples.expanded);
+		result["nodes_expanded_p99"] = percentile(samples.expanded, 0.99);
+	}
+	return result;
+}
+
+void Bench::write(const nlohmann::json& results, const std::string& out)
+{
+	if (out.empty())
+	{
+		std::cout << results.dump(2) << std::endl;
+	}
+	else
+	{
+		std::ofstream file(out);
+		file << results.dump(2) << std::endl;
+	}
+}
+
+void Bench::check(bool ok, const std::string& what)
+{
+	std::cout << (ok ? "ok     " : "FAILED ") << what << std::endl;
+	if (!ok)
+		failedChecks++;
+}
+
+int Bench::checkResult()
+{
+	return failedChecks == 0 ? 0 : 1;
+}
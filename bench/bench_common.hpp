@@ -0,0 +1,40 @@
+#pragma once
+
+// Shared by the headless benchmarks and checks in bench/, none of them open a window or make a GL context
+
+// stlib
+#include <string>
+#include <vector>
+
+#include <../ext/nlohmann_json/single_include/nlohmann/json.hpp>
+
+class Bench
+{
+public:
+	// every allocation in the process so far, read before and after the measured code
+	static long long allocations();
+
+	// one entry per measured run
+	struct Samples
+	{
+		std::vector<double> microseconds;
+		std::vector<double> allocations;
+		// left empty by benchmarks that don't search
+		std::vector<double> expanded;
+	};
+
+	static double percentile(std::vector<double> values, double fraction);
+	static double mean(const std::vector<double>& values);
+	static nlohmann::json report(const Samples& samples);
+
+	// prints the results, or writes them to the file if one is given
+	static void write(const nlohmann::json& results, const std::string& out);
+
+	// prints the check and whether it held, counting the ones that didn't
+	static void check(bool ok, const std::string& what);
+	// exit code of a check program, non-zero if any check failed
+	static int checkResult();
+
+private:
+	static int failedChecks;
+};
@@ -0,0 +1,103 @@
+// header
+#include "bench_world.hpp"
+
+// internal
+#include "particle.hpp"
+#include "projectile.hpp"
+#include "render_components.hpp"
+#include "spider.hpp"
+#include "tiles/tiles.hpp"
+#include "tiles/wall.hpp"
+
+// stlib
+#include <unordered_map>
+
+const float BenchWorld::SCALE = 50.f;
+const vec2 BenchWorld::WINDOW_SIZE = { 1200, 800 };
+
+void BenchWorld::reset(const std::vector<std::string>& rows, bool wallEntities)
+{
+	ECS::ContainerInterface::clear_all_components();
+	TileSystem::resetGrid();
+	TileSystem::setScale(SCALE);
+	auto& tiles = TileSystem::getTiles();
+	for (size_t row = 0; row < rows.size(); row++)
+	{
+		std::vector<Tile> tileRow;
+		for (size_t col = 0; col < rows[row].size(); col++)
+		{
+			Tile tile;
+			tile.x = (col + 0.5f) * SCALE;
+			tile.y = (row + 0.5f) * SCALE;
+			tile.type = rows[row][col] == 'X' ? WALL : EMPTY;
+			if (tile.type == WALL && wallEntities)
+				addWall({ tile.x, tile.y });
+			tileRow.push_back(tile);
+		}
+		tiles.push_back(tileRow);
+	}
+	Camera::reset();
+	ECS::Entity turnEntity;
+	ECS::registry<Turn>.emplace(turnEntity).type = ENEMY;
+	// the weather would need meshes
+	WeatherParentParticle::count = 0;
+}
+
+vec2 BenchWorld::characterScale(const std::string& name, float size)
+{
+	Mesh full;
+	full.loadFromOBJFile(mesh_path(name + ".obj"));
+	vec2 scale = full.original_size / full.original_size.x * size;
+	scale.y *= -1; // fix orientation
+	return scale;
+}
+
+ECS::Entity BenchWorld::addCharacter(const std::string& name, float size, vec2 position)
+{
+	ShadedMesh& resource = cache_resource("bench-" + name + "-min");
+	if (resource.mesh.vertices.size() == 0)
+		resource.mesh.loadFromMinOBJFile(mesh_path(name + "-min.obj"));
+	// loading the full mesh for every character would take longer than what is measured
+	static std::unordered_map<std::string, vec2> scales;
+	std::string key = name + "-" + std::to_string(size);
+	if (scales.find(key) == scales.end())
+		scales[key] = characterScale(name, size);
+
+	ECS::Entity entity;
+	auto& motion = ECS::registry<Motion>.emplace(entity);
+	motion.position = position;
+	motion.scale = scales[key];
+	ECS::registry<MinShadedMeshRef>.emplace(entity, resource, RenderBucket::CHARACTER);
+	return entity;
+}
+
+ECS::Entity BenchWorld::addSpider(vec2 position)
+{
+	ECS::Entity spider = addCharacter("spider", SCALE * 0.9f, position);
+	ECS::registry<Enemy>.emplace(spider);
+	ECS::registry<Spider>.emplace(spider);
+	return spider;
+}
+
+ECS::Entity BenchWorld::addShell(vec2 position, vec2 velocity)
+{
+	ECS::Entity shell = addCharacter("shell", SCALE / 5.f, position);
+	ECS::registry<Motion>.get(shell).velocity = velocity;
+	ECS::registry<Projectile>.emplace(shell);
+	ECS::registry<SnailProjectile>.emplace(shell);
+	return shell;
+}
+
+void BenchWorld::addWall(vec2 position)
+{
+	ShadedMesh& resource = cache_resource("bench-wall-min");
+	if (resource.mesh.vertices.size() == 0)
+		resource.mesh.loadFromMinOBJFile(mesh_path("wall-min.obj"));
+	ECS::Entity entity;
+	ECS::registry<MinShadedMeshRef>.emplace(entity, resource, RenderBucket::TILE);
+	auto& motion = ECS::registry<Motion>.emplace(entity);
+	motion.position = position;
+	motion.scale = { SCALE, -SCALE };
+	ECS::registry<WallTile>.emplace(entity);
+	ECS::registry<Occluder>.emplace(entity);
+}
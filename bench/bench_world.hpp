@@ -0,0 +1,50 @@
+#pragma once
+
+// internal
+#include "common.hpp"
+#include "event.hpp"
+#include "observer.hpp"
+#include "physics.hpp"
+#include "tiny_ecs.hpp"
+
+// stlib
+#include <string>
+#include <vector>
+
+// Game worlds for the headless benchmarks and checks, the entities get what their create functions give them minus the
+// rendering, which needs a GL context
+class BenchWorld
+{
+public:
+	// size of a tile
+	static const float SCALE;
+	static const vec2 WINDOW_SIZE;
+
+	// Clears all entities and lays out the tiles, one string per row with 'X' for a wall and anything else empty.
+	// With wallEntities the walls also get an entity with a Motion and collision mesh, like in a loaded level.
+	// The enemies have their turn, i.e. the projectiles fly.
+	static void reset(const std::vector<std::string>& rows, bool wallEntities = false);
+
+	// the scale the create function of a character gives it, from the size of its full mesh
+	static vec2 characterScale(const std::string& name, float size);
+
+	// an entity with the collision mesh and scale of a character
+	static ECS::Entity addCharacter(const std::string& name, float size, vec2 position);
+	static ECS::Entity addSpider(vec2 position);
+	static ECS::Entity addShell(vec2 position, vec2 velocity);
+
+	// the contacts physics reports
+	struct ContactLog : public Observer
+	{
+		std::vector<CollisionContact> contacts;
+
+		void onNotify(Event event) override
+		{
+			if (event.type == Event::CONTACTS)
+				contacts.insert(contacts.end(), event.contacts->begin(), event.contacts->end());
+		}
+	};
+
+private:
+	static void addWall(vec2 position);
+};
@@ -0,0 +1,402 @@
+// Headless benchmark of the ECS component storage: the paged sparse-set index of ComponentContainer against the hash
+// map it replaced, and the views in the game loops against the hand-written loops they replaced, at a few entity counts.
+// Prints the results as JSON. See --help for the options.
+
+// internal
+#include "bench_common.hpp"
+#include "common.hpp"
+#include "render_components.hpp"
+#include "tiny_ecs.hpp"
+
+// stlib
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using json = nlohmann::json;
+
+struct Options
+{
+	std::vector<int> counts = { 1000, 10000, 100000 };
+	int repeats = 20;
+	unsigned int seed = 1;
+	std::string out;
+};
+
+static bool parseOptions(int argc, char* argv[], Options& options)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		if (arg == "--help" || i + 1 >= argc)
+			return false;
+		std::string value = argv[++i];
+		if (arg == "--count")
+			options.counts = { std::stoi(value) };
+		else if (arg == "--repeats")
+			options.repeats = std::stoi(value);
+		else if (arg == "--seed")
+			options.seed = static_cast<unsigned int>(std::stoul(value));
+		else if (arg == "--out")
+			options.out = value;
+		else
+			return false;
+	}
+	for (int count : options.counts)
+	{
+		// the entity index has 20 bits
+		if (count < 2 || count >= static_cast<int>(ECS::Entity::index_mask))
+			return false;
+	}
+	return options.repeats > 0;
+}
+
+// about the size of a Motion
+struct Payload
+{
+	float values[12] = {};
+};
+
+// The component storage as it was before the sparse set: a hash map from entity id to array index
+class HashMapContainer
+{
+public:
+	std::vector<Payload> components;
+	std::vector<ECS::Entity> entities;
+
+	Payload& emplace(ECS::Entity e)
+	{
+		map_entity_component_index[e.id] = static_cast<unsigned int>(components.size());
+		components.emplace_back();
+		entities.push_back(e);
+		return components.back();
+	}
+
+	Payload& get(ECS::Entity e)
+	{
+		return components[map_entity_component_index.find(e.id)->second];
+	}
+
+	bool has(ECS::Entity e)
+	{
+		return map_entity_component_index.find(e.id) != map_entity_component_index.end();
+	}
+
+	void remove(ECS::Entity e)
+	{
+		const auto it = map_entity_component_index.find(e.id);
+		if (it == map_entity_component_index.end())
+			return;
+		unsigned int array_index = it->second;
+		components[array_index] = std::move(components.back());
+		entities[array_index] = entities.back();
+		map_entity_component_index[entities.back().id] = array_index;
+		map_entity_component_index.erase(e.id);
+		components.pop_back();
+		entities.pop_back();
+	}
+
+	void clear()
+	{
+		map_entity_component_index.clear();
+		components.clear();
+		entities.clear();
+	}
+
+private:
+	std::unordered_map<unsigned int, unsigned int> map_entity_component_index;
+};
+
+// the sparse set under test, a registry like every other component type
+class SparseSetContainer
+{
+public:
+	Payload& emplace(ECS::Entity e) { return ECS::registry<Payload>.emplace(e); }
+	Payload& get(ECS::Entity e) { return ECS::registry<Payload>.get(e); }
+	bool has(ECS::Entity e) { return ECS::registry<Payload>.has(e); }
+	void remove(ECS::Entity e) { ECS::registry<Payload>.remove(e); }
+	void clear() { ECS::registry<Payload>.clear(); }
+};
+
+// nanoseconds and allocations per operation, one entry per run
+struct Timing
+{
+	std::vector<double> nanoseconds;
+	std::vector<double> allocations;
+};
+
+template <typename Function>
+static void measure(Timing& timing, size_t operations, Function f)
+{
+	long long allocated = Bench::allocations();
+	auto begin = std::chrono::high_resolution_clock::now();
+	f();
+	auto end = std::chrono::high_resolution_clock::now();
+	timing.nanoseconds.push_back(std::chrono::duration<double, std::nano>(end - begin).count() / operations);
+	timing.allocations.push_back(static_cast<double>(Bench::allocations() - allocated) / operations);
+}
+
+static json report(const Timing& timing)
+{
+	return {
+		{ "p50_ns", Bench::percentile(timing.nanoseconds, 0.5) },
+		{ "p99_ns", Bench::percentile(timing.nanoseconds, 0.99) },
+		{ "mean_ns", Bench::mean(timing.nanoseconds) },
+		{ "allocations_mean", Bench::mean(timing.allocations) },
+	};
+}
+
+// Adds a component to half of the entities, looks those up in random order, asks every entity whether it has one,
+// and removes half of the components again in random order
+template <typename Container>
+static json benchmarkContainer(Container& container, const std::vector<ECS::Entity>& entities, const Options& options)
+{
+	std::mt19937 random(options.seed);
+	Timing emplace, get, has, remove;
+	float sink = 0.f;
+	for (int repeat = 0; repeat < options.repeats; repeat++)
+	{
+		container.clear();
+		std::vector<ECS::Entity> withComponent(entities.begin(), entities.begin() + entities.size() / 2);
+		std::vector<ECS::Entity> shuffled = withComponent;
+		std::shuffle(shuffled.begin(), shuffled.end(), random);
+		std::vector<ECS::Entity> asked = entities;
+		std::shuffle(asked.begin(), asked.end(), random);
+
+		measure(emplace, withComponent.size(), [&]() {
+			for (auto entity : withComponent)
+				container.emplace(entity).values[0] = 1.f;
+		});
+		measure(get, shuffled.size(), [&]() {
+			for (auto entity : shuffled)
+				sink += container.get(entity).values[0];
+		});
+		measure(has, asked.size(), [&]() {
+			for (auto entity : asked)
+				sink += container.has(entity) ? 1.f : 0.f;
+		});
+		measure(remove, shuffled.size() / 2, [&]() {
+			for (size_t i = 0; i < shuffled.size() / 2; i++)
+				container.remove(shuffled[i]);
+		});
+	}
+	container.clear();
+	// keeps the lookups from being optimized away
+	if (sink < 0.f)
+		std::cout << sink << std::endl;
+
+	return {
+		{ "emplace", report(emplace) },
+		{ "get", report(get) },
+		{ "has", report(has) },
+		{ "remove", report(remove) },
+	};
+}
+
+// A world with every entity drawn and moving, some walking to a destination (half of those around a corner), and a few
+// overlays, backgrounds and dying entities
+static void populateWorld(const std::vector<ECS::Entity>& entities, std::mt19937& random)
+{
+	ShadedMesh& mesh = cache_resource("bench-view");
+	std::uniform_real_distribution<float> chance(0.f, 1.f);
+	for (auto entity : entities)
+	{
+		ECS::registry<Motion>.emplace(entity).position = { chance(random), chance(random) };
+		ECS::registry<ShadedMeshRef>.emplace(entity, mesh, RenderBucket::CHARACTER);
+		float roll = chance(random);
+		if (roll < 0.2f)
+		{
+			ECS::registry<Destination>.emplace(entity);
+			if (roll < 0.1f)
+				ECS::registry<CornerMotion>.emplace(entity);
+		}
+		else if (roll < 0.25f)
+			ECS::registry<Overlay>.emplace(entity);
+		else if (roll < 0.3f)
+			ECS::registry<Parallax>.emplace(entity, Parallax::LAYER_2);
+		else if (roll < 0.35f)
+			ECS::registry<DeathTimer>.emplace(entity);
+	}
+}
+
+// A loop of a frame that uses a view, and the hand-written loop it replaced
+struct ViewLoop
+{
+	std::string name;
+	std::function<void()> view;
+	std::function<void()> handWritten;
+};
+
+static void time(Bench::Samples& samples, const std::function<void()>& loop)
+{
+	long long allocated = Bench::allocations();
+	auto begin = std::chrono::high_resolution_clock::now();
+	loop();
+	auto end = std::chrono::high_resolution_clock::now();
+	double allocations = static_cast<double>(Bench::allocations() - allocated);
+	samples.microseconds.push_back(std::chrono::duration<double, std::micro>(end - begin).count());
+	samples.allocations.push_back(allocations);
+}
+
+// The loops of a frame that use views, each as a view and as the loop it replaced, and all of them together as a frame.
+// Which of the two runs first alternates, the second one finds the components in the cache.
+static json benchmarkViews(const std::vector<ECS::Entity>& entities, const Options& options)
+{
+	std::mt19937 random(options.seed);
+	populateWorld(entities, random);
+	float sink = 0.f;
+
+	const ViewLoop loops[] = {
+		{
+			// RenderSystem::draw, the world pass
+			"render_world_pass",
+			[&]()
+			{
+				ECS::view<ShadedMeshRef, Motion, ECS::Not<Overlay>>().each_in_order_of<ShadedMeshRef>(
+					[&](ECS::Entity, ShadedMeshRef&, Motion& motion) { sink += motion.position.x; });
+			},
+			[&]()
+			{
+				for (ECS::Entity entity : ECS::registry<ShadedMeshRef>.entities)
+				{
+					if (!ECS::registry<Motion>.has(entity))
+						continue;
+					if (ECS::registry<Overlay>.has(entity))
+						continue;
+					sink += ECS::registry<Motion>.get(entity).position.x;
+				}
+			},
+		},
+		{
+			// PhysicsSystem::step, starting to round corners
+			"physics_corner_motion",
+			[&]()
+			{
+				ECS::view<Destination, Motion, ECS::Not<CornerMotion>>().each(
+					[&](ECS::Entity, Destination&, Motion& motion) { sink += motion.position.y; });
+			},
+			[&]()
+			{
+				for (auto entity : ECS::registry<Destination>.entities)
+				{
+					auto& motion = ECS::registry<Motion>.get(entity);
+					if (!ECS::registry<CornerMotion>.has(entity))
+						sink += motion.position.y;
+				}
+			},
+		},
+		{
+			// PhysicsSystem::step, the debug crosses
+			"physics_debug_crosses",
+			[&]()
+			{
+				ECS::view<Motion, ECS::Not<Overlay>, ECS::Not<Parallax>>().each(
+					[&](ECS::Entity, Motion& motion) { sink += motion.scale.x; });
+			},
+			[&]()
+			{
+				auto& motion_container = ECS::registry<Motion>;
+				for (int i = static_cast<int>(motion_container.components.size()) - 1; i >= 0; i--)
+				{
+					ECS::Entity entity = motion_container.entities[i];
+					if (ECS::registry<Overlay>.has(entity))
+						continue;
+					if (ECS::registry<Parallax>.has(entity))
+						continue;
+					sink += motion_container.components[i].scale.x;
+				}
+			},
+		},
+		{
+			// WorldSystem::step, the dying entities
+			"world_death_timers",
+			[&]()
+			{
+				ECS::view<DeathTimer, Motion>().each(
+					[&](ECS::Entity, DeathTimer& counter, Motion& motion) { sink += counter.counter_ms + motion.position.x; });
+			},
+			[&]()
+			{
+				for (auto entity : ECS::registry<DeathTimer>.entities)
+				{
+					if (!ECS::registry<Motion>.has(entity))
+						continue;
+					sink += ECS::registry<DeathTimer>.get(entity).counter_ms + ECS::registry<Motion>.get(entity).position.x;
+				}
+			},
+		},
+	};
+
+	std::map<std::string, Bench::Samples> viewSamples, handWrittenSamples;
+	Bench::Samples viewFrame, handWrittenFrame;
+	auto frame = [&](bool views)
+	{
+		for (const auto& loop : loops)
+			views ? loop.view() : loop.handWritten();
+	};
+	for (int repeat = 0; repeat < options.repeats; repeat++)
+	{
+		bool viewsFirst = repeat % 2 == 0;
+		for (const auto& loop : loops)
+		{
+			time(viewsFirst ? viewSamples[loop.name] : handWrittenSamples[loop.name], viewsFirst ? loop.view : loop.handWritten);
+			time(viewsFirst ? handWrittenSamples[loop.name] : viewSamples[loop.name], viewsFirst ? loop.handWritten : loop.view);
+		}
+		time(viewsFirst ? viewFrame : handWrittenFrame, [&]() { frame(viewsFirst); });
+		time(viewsFirst ? handWrittenFrame : viewFrame, [&]() { frame(!viewsFirst); });
+	}
+	ECS::ContainerInterface::remove_all_components_of(entities);
+	// keeps the loops from being optimized away
+	if (sink < 0.f)
+		std::cout << sink << std::endl;
+
+	json results;
+	results["view"]["frame"] = Bench::report(viewFrame);
+	results["hand_written"]["frame"] = Bench::report(handWrittenFrame);
+	for (const auto& loop : loops)
+	{
+		results["view"][loop.name] = Bench::report(viewSamples[loop.name]);
+		results["hand_written"][loop.name] = Bench::report(handWrittenSamples[loop.name]);
+	}
+	return results;
+}
+
+int main(int argc, char* argv[])
+{
+	Options options;
+	if (!parseOptions(argc, argv, options))
+	{
+		std::cerr << "usage: ecs_bench [--count N] [--repeats N] [--seed N] [--out FILE]" << std::endl;
+		return 1;
+	}
+
+	json results;
+	results["repeats"] = options.repeats;
+	results["seed"] = options.seed;
+	for (int count : options.counts)
+	{
+		// in random order, so half of them is a random half of the ids
+		std::vector<ECS::Entity> entities;
+		for (int i = 0; i < count; i++)
+			entities.push_back(ECS::Entity());
+		std::shuffle(entities.begin(), entities.end(), std::mt19937(options.seed));
+
+		HashMapContainer hashMap;
+		SparseSetContainer sparseSet;
+		std::string key = std::to_string(count);
+		results["entities"][key]["hash_map"] = benchmarkContainer(hashMap, entities, options);
+		results["entities"][key]["sparse_set"] = benchmarkContainer(sparseSet, entities, options);
+		results["entities"][key]["views"] = benchmarkViews(entities, options);
+		for (auto entity : entities)
+			ECS::Entity::release(entity);
+	}
+
+	Bench::write(results, options.out);
+	return 0;
+}
@@ -0,0 +1,206 @@
+// Headless benchmark of the physics step on a wide generated level with hundreds of spiders and flying shells, no window
+// or GL context. Reads the meshes from data/ in the working directory. Prints the results as JSON. See --help for the options.
+
+// internal
+#include "bench_common.hpp"
+#include "bench_world.hpp"
+#include "common.hpp"
+#include "hull.hpp"
+#include "physics.hpp"
+#include "profiler.hpp"
+#include "render_components.hpp"
+#include "tiny_ecs.hpp"
+
+// stlib
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using json = nlohmann::json;
+
+struct Options
+{
+	int rows = 40;
+	int columns = 400;
+	float wallDensity = 0.1f;
+	std::vector<int> counts = { 100, 300, 1000 };
+	int frames = 300;
+	unsigned int seed = 1;
+	std::string out;
+};
+
+static bool parseOptions(int argc, char* argv[], Options& options)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		if (arg == "--help" || i + 1 >= argc)
+			return false;
+		std::string value = argv[++i];
+		if (arg == "--rows")
+			options.rows = std::stoi(value);
+		else if (arg == "--columns")
+			options.columns = std::stoi(value);
+		else if (arg == "--walls")
+			options.wallDensity = std::stof(value);
+		else if (arg == "--count")
+			options.counts = { std::stoi(value) };
+		else if (arg == "--frames")
+			options.frames = std::stoi(value);
+		else if (arg == "--seed")
+			options.seed = static_cast<unsigned int>(std::stoul(value));
+		else if (arg == "--out")
+			options.out = value;
+		else
+			return false;
+	}
+	for (int count : options.counts)
+	{
+		if (count < 2)
+			return false;
+	}
+	return options.rows >= 3 && options.columns >= 3 && options.frames > 0;
+}
+
+// A level with walls all around and randomly placed ones inside, gives the empty tiles
+static std::vector<ivec2> generateLevel(const Options& options, std::mt19937& random)
+{
+	std::bernoulli_distribution wall(options.wallDensity);
+	std::vector<std::string> tiles;
+	std::vector<ivec2> empty;
+	for (int row = 0; row < options.rows; row++)
+	{
+		std::string tileRow;
+		for (int col = 0; col < options.columns; col++)
+		{
+			bool edge = row == 0 || col == 0 || row == options.rows - 1 || col == options.columns - 1;
+			bool isWall = edge || wall(random);
+			tileRow += isWall ? 'X' : ' ';
+			if (!isWall)
+				empty.push_back({ col, row });
+		}
+		tiles.push_back(tileRow);
+	}
+	BenchWorld::reset(tiles, true);
+	return empty;
+}
+
+// Every pair of entities with a collision mesh tested on their bounding circles, which the physics step did for all
+// pairs before the broadphase. Gives the number of pairs whose circles overlap.
+static int allPairsCircleTest(std::vector<CollisionHull>& hulls)
+{
+	auto& meshes = ECS::registry<MinShadedMeshRef>;
+	hulls.resize(meshes.size());
+	for (size_t i = 0; i < meshes.size(); i++)
+		hulls[i].update(meshes.components[i].reference_to_cache->mesh, ECS::registry<Motion>.get(meshes.entities[i]));
+	int overlapping = 0;
+	for (size_t i = 0; i < hulls.size(); i++)
+	{
+		for (size_t j = i + 1; j < hulls.size(); j++)
+		{
+			float radiusSum = hulls[i].radius + hulls[j].radius;
+			if (length(hulls[i].center - hulls[j].center) <= radiusSum)
+				overlapping++;
+		}
+	}
+	return overlapping;
+}
+
+// Half spiders, half shells flying in random directions, on random empty tiles. Steps the physics at 60 Hz during the
+// enemies' turn, with the all-pairs circle test timed next to it as the reference.
+static json benchmarkCount(int count, const Options& options)
+{
+	std::mt19937 random(options.seed);
+	std::vector<ivec2> empty = generateLevel(options, random);
+	std::uniform_int_distribution<size_t> anyTile(0, empty.size() - 1);
+	std::uniform_real_distribution<float> angle(0.f, 2.f * PI);
+	std::uniform_real_distribution<float> speed(200.f, 1500.f);
+	for (int i = 0; i < count; i++)
+	{
+		ivec2 tile = empty[anyTile(random)];
+		vec2 position = { (tile.x + 0.5f) * BenchWorld::SCALE, (tile.y + 0.5f) * BenchWorld::SCALE };
+		if (i % 2 == 0)
+		{
+			BenchWorld::addSpider(position);
+		}
+		else
+		{
+			float a = angle(random);
+			BenchWorld::addShell(position, vec2(std::cos(a), std::sin(a)) * speed(random));
+		}
+	}
+	size_t entities = ECS::registry<Motion>.size();
+
+	PhysicsSystem physics;
+	BenchWorld::ContactLog log;
+	physics.addObserver(&log);
+	Bench::Samples step, allPairs;
+	std::vector<double> candidatePairs, contacts, overlapping;
+	std::vector<CollisionHull> hulls;
+	// one frame to build the hulls and bin the bodies, which is a level load's cost rather than a frame's
+	physics.step(1000.f / 60.f, BenchWorld::WINDOW_SIZE);
+	allPairsCircleTest(hulls);
+	Profiler::frame = FrameStats();
+	for (int frame = 0; frame < options.frames; frame++)
+	{
+		log.contacts.clear();
+		long long allocated = Bench::allocations();
+		auto begin = std::chrono::high_resolution_clock::now();
+		physics.step(1000.f / 60.f, BenchWorld::WINDOW_SIZE);
+		auto end = std::chrono::high_resolution_clock::now();
+		double allocations = static_cast<double>(Bench::allocations() - allocated);
+		step.microseconds.push_back(std::chrono::duration<double, std::micro>(end - begin).count());
+		step.allocations.push_back(allocations);
+		candidatePairs.push_back(Profiler::frame.collisionPairs);
+		contacts.push_back(static_cast<double>(log.contacts.size()));
+		Profiler::frame = FrameStats();
+
+		allocated = Bench::allocations();
+		begin = std::chrono::high_resolution_clock::now();
+		int overlaps = allPairsCircleTest(hulls);
+		end = std::chrono::high_resolution_clock::now();
+		allocations = static_cast<double>(Bench::allocations() - allocated);
+		allPairs.microseconds.push_back(std::chrono::duration<double, std::micro>(end - begin).count());
+		allPairs.allocations.push_back(allocations);
+		overlapping.push_back(overlaps);
+	}
+	ECS::ContainerInterface::clear_all_components();
+
+	return {
+		{ "entities", entities },
+		{ "all_pairs", entities * (entities - 1) / 2 },
+		{ "candidate_pairs_mean", Bench::mean(candidatePairs) },
+		{ "overlapping_circles_mean", Bench::mean(overlapping) },
+		{ "contacts_mean", Bench::mean(contacts) },
+		{ "step", Bench::report(step) },
+		{ "all_pairs_circle_test", Bench::report(allPairs) },
+	};
+}
+
+int main(int argc, char* argv[])
+{
+	Options options;
+	if (!parseOptions(argc, argv, options))
+	{
+		std::cerr << "usage: physics_bench [--rows N] [--columns N] [--walls DENSITY] [--count N] [--frames N] [--seed N] "
+			"[--out FILE]" << std::endl;
+		return 1;
+	}
+
+	json results;
+	results["level"] = {
+		{ "rows", options.rows },
+		{ "columns", options.columns },
+		{ "wall_density", options.wallDensity },
+		{ "frames", options.frames },
+		{ "seed", options.seed },
+	};
+	for (int count : options.counts)
+		results["bodies"][std::to_string(count)] = benchmarkCount(count, options);
+
+	Bench::write(results, options.out);
+	return 0;
+}
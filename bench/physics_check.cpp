@@ -0,0 +1,234 @@
+// Headless checks of the collision code on the shipped meshes, no window or GL context.
+// Reads data/ from the working directory like the game does. Exits non-zero if any check fails.
+
+// internal
+#include "bench_common.hpp"
+#include "bench_world.hpp"
+#include "common.hpp"
+#include "hull.hpp"
+#include "physics.hpp"
+#include "render_components.hpp"
+#include "tiny_ecs.hpp"
+
+// stlib
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static const float SCALE = BenchWorld::SCALE;
+
+// a character's collision hull on its own, outside of the ECS
+struct Character
+{
+	Mesh collision;
+	Motion motion;
+
+	Character(const std::string& name, float size)
+	{
+		collision.loadFromMinOBJFile(mesh_path(name + "-min.obj"));
+		motion.scale = BenchWorld::characterScale(name, size);
+	}
+
+	const CollisionHull& hull(vec2 position)
+	{
+		motion.position = position;
+		cached.update(collision, motion);
+		return cached;
+	}
+
+private:
+	CollisionHull cached;
+};
+
+// the bird's collision mesh is a list of triangles. Tested as a single outline it covered the whole convex hull of the
+// bird, and a shell passing under its wing (where nothing is) hit it.
+static void checkTriangleMeshes()
+{
+	Character bird("bird", SCALE * 0.9f);
+	Character shell("shell", SCALE / 5.f);
+	const CollisionHull& birdHull = bird.hull({ 0.f, 0.f });
+	CollisionHull::Contact contact;
+
+	Bench::check(birdHull.pieces.size() == bird.collision.face_offsets.size(), "every face of the bird mesh is a piece");
+
+	// clear of every triangle, by a few pixels in every direction
+	bool clear = true;
+	for (float dx = -4.f; dx <= 4.f; dx += 1.f)
+	{
+		for (float dy = -4.f; dy <= 4.f; dy += 1.f)
+			clear = clear && !CollisionHull::overlap(shell.hull({ -16.f + dx, 11.f + dy }), birdHull, contact);
+	}
+	Bench::check(clear, "a shell under the bird's wing doesn't hit it");
+
+	Bench::check(CollisionHull::overlap(shell.hull({ 0.f, 0.f }), birdHull, contact) && contact.depth > 0.f,
+		"a shell in the middle of the bird hits it");
+
+	// flying under the wing for a whole step
+	float toi = 0.f;
+	Bench::check(!CollisionHull::sweep(shell.hull({ -14.f, 11.f }), { 4.f, 0.f }, birdHull, toi, contact),
+		"a shell sweeping under the bird's wing doesn't hit it");
+	Bench::check(CollisionHull::sweep(shell.hull({ 0.f, 0.f }), { 40.f, 0.f }, birdHull, toi, contact) && toi > 0.f && toi < 1.f,
+		"a shell flying into the bird hits it during the step");
+}
+
+// A room with walls all around, and a wall one tile thick at wallColumn if it's in the room
+static void buildRoom(int rows, int columns, int wallColumn)
+{
+	std::vector<std::string> tiles;
+	for (int row = 0; row < rows; row++)
+	{
+		std::string tileRow;
+		for (int col = 0; col < columns; col++)
+		{
+			bool edge = row == 0 || col == 0 || row == rows - 1 || col == columns - 1;
+			tileRow += edge || col == wallColumn ? 'X' : ' ';
+		}
+		tiles.push_back(tileRow);
+	}
+	BenchWorld::reset(tiles);
+}
+
+// A shell fast enough to cross four tiles in a 15 Hz frame, fired at a wall one tile thick. Replayed through
+// PhysicsSystem::step at 15, 60 and 240 steps a second for a fifth of a second, it has to bounce off the same wall tile
+// every time, never get into (or through) the wall, and end up in the same place.
+static void checkThinWall()
+{
+	const int wallColumn = 6;
+	const vec2 start = { 75.f, 130.f };
+	const vec2 velocity = { 3000.f, 450.f };
+
+	bool first = true;
+	vec2 end = { 0, 0 };
+	for (int hz : { 15, 60, 240 })
+	{
+		buildRoom(8, 10, wallColumn);
+		ECS::Entity shell = BenchWorld::addShell(start, velocity);
+		vec2 scale = ECS::registry<Motion>.get(shell).scale;
+		vec2 half = vec2(std::abs(scale.x), std::abs(scale.y)) / 2.f;
+		// where its leading edge reaches the face of the wall, if nothing goes wrong
+		float impact = (wallColumn * SCALE - (start.x + half.x)) / velocity.x;
+		ivec2 expected = { static_cast<int>(std::floor((start.y + velocity.y * impact) / SCALE)), wallColumn };
+
+		PhysicsSystem physics;
+		float stepMs = 1000.f / hz;
+		bool bounced = false;
+		bool inWall = false;
+		ivec2 hit = { -1, -1 };
+		for (int step = 0; step < hz / 5; step++)
+		{
+			vec2 before = ECS::registry<Motion>.get(shell).position;
+			vec2 velocityBefore = ECS::registry<Motion>.get(shell).velocity;
+			physics.step(stepMs, BenchWorld::WINDOW_SIZE);
+			const Motion& after = ECS::registry<Motion>.get(shell);
+			inWall = inWall || after.position.x + half.x > wallColumn * SCALE;
+			if (!bounced && after.velocity.x * velocityBefore.x < 0.f)
+			{
+				// the step it turned around in, trace it back to the wall face
+				bounced = true;
+				float t = (wallColumn * SCALE - (before.x + half.x)) / velocityBefore.x;
+				hit = { static_cast<int>(std::floor((before.y + velocityBefore.y * t) / SCALE)), wallColumn };
+			}
+		}
+
+		std::string rate = std::to_string(hz) + " Hz";
+		Bench::check(bounced && hit == expected, "at " + rate + " the shell bounces off the wall at tile (" +
+			std::to_string(hit.x) + ", " + std::to_string(hit.y) + "), expected (" + std::to_string(expected.x) + ", " +
+			std::to_string(expected.y) + ")");
+		Bench::check(!inWall, "at " + rate + " the shell stays out of the wall");
+		// the bounces are exact, only the rounding differs between the rates
+		vec2 position = ECS::registry<Motion>.get(shell).position;
+		if (first)
+			end = position;
+		else
+			Bench::check(length(position - end) < 0.5f, "at " + rate + " the shell ends up where it does at 15 Hz");
+		first = false;
+	}
+	ECS::ContainerInterface::clear_all_components();
+}
+
+// whether physics reported a contact between the two, either way around
+static bool touched(const std::vector<CollisionContact>& contacts, ECS::Entity a, ECS::Entity b)
+{
+	for (const auto& contact : contacts)
+	{
+		if ((contact.entity.id == a.id && contact.other.id == b.id) || (contact.entity.id == b.id && contact.other.id == a.id))
+			return true;
+	}
+	return false;
+}
+
+// The same shell fired at a spider. At 15 Hz it is in front of the spider before a step and past it after, it has to hit
+// it anyway, at every rate.
+static void checkFastShellHitsSpider()
+{
+	for (int hz : { 15, 60, 240 })
+	{
+		buildRoom(5, 12, -1);
+		ECS::Entity spider = BenchWorld::addSpider({ 225.f, 125.f });
+		ECS::Entity shell = BenchWorld::addShell({ 60.f, 125.f }, { 3000.f, 0.f });
+
+		PhysicsSystem physics;
+		BenchWorld::ContactLog log;
+		physics.addObserver(&log);
+		float stepMs = 1000.f / hz;
+		for (int step = 0; step < hz / 15 && log.contacts.empty(); step++)
+			physics.step(stepMs, BenchWorld::WINDOW_SIZE);
+
+		Bench::check(touched(log.contacts, shell, spider), "at " + std::to_string(hz) + " Hz the shell hits the spider it flies past");
+
+		// the contact normal is flipped along with the pair, it points out of other, against entity's approach
+		bool outward = false;
+		for (const auto& contact : log.contacts)
+		{
+			vec2 approach = ECS::registry<Motion>.get(contact.entity).velocity - ECS::registry<Motion>.get(contact.other).velocity;
+			outward = outward || (contact.depth >= 0.f && dot(contact.normal, approach) < 0.f);
+		}
+		Bench::check(outward, "at " + std::to_string(hz) + " Hz the contact normal points out of the other body");
+	}
+	ECS::ContainerInterface::clear_all_components();
+}
+
+// the contacts of a fifteenth of a second of physics steps at hz
+static std::vector<CollisionContact> replay(int hz)
+{
+	PhysicsSystem physics;
+	BenchWorld::ContactLog log;
+	physics.addObserver(&log);
+	for (int step = 0; step < hz / 15; step++)
+		physics.step(1000.f / hz, BenchWorld::WINDOW_SIZE);
+	return log.contacts;
+}
+
+// Shells that bounce off a wall within a 15 Hz step. Only the path they took counts, not the straight line from where
+// they started to where they ended up: at every rate, a spider passed before the bounce is hit and one between the two
+// legs of the path isn't.
+static void checkBouncingShell()
+{
+	for (int hz : { 15, 60, 240 })
+	{
+		std::string rate = std::to_string(hz) + " Hz";
+
+		// at a wall and back, past a spider in front of the wall
+		buildRoom(5, 14, 10);
+		ECS::Entity spider = BenchWorld::addSpider({ 425.f, 125.f });
+		ECS::Entity shell = BenchWorld::addShell({ 75.f, 125.f }, { 9000.f, 0.f });
+		Bench::check(touched(replay(hz), shell, spider), "at " + rate + " the shell hits the spider it passes before bouncing back");
+
+		// up against the ceiling and back down, over a spider
+		buildRoom(6, 10, -1);
+		spider = BenchWorld::addSpider({ 225.f, 215.f });
+		shell = BenchWorld::addShell({ 75.f, 240.f }, { 4500.f, -4500.f });
+		Bench::check(!touched(replay(hz), shell, spider), "at " + rate + " the shell doesn't hit the spider under where it bounced");
+	}
+	ECS::ContainerInterface::clear_all_components();
+}
+
+int main()
+{
+	checkTriangleMeshes();
+	checkThinWall();
+	checkFastShellHitsSpider();
+	checkBouncingShell();
+	return Bench::checkResult();
+}
@@ -2,6 +2,9 @@
 #include "ai.hpp"
 #include "tiny_ecs.hpp"
 #include "tiles/tiles.hpp"
+#include "crawl_graph.hpp"
+#include "crawl_clusters.hpp"
+#include "visibility.hpp"
 #include "snail.hpp"
 #include "spider.hpp"
 #include "slug.hpp"
@@ -11,16 +14,138 @@
 #include "render_components.hpp"
 #include "debug.hpp"
 #include "projectile.hpp"
+#include "profiler.hpp"
 
 // stlib
 #include <iostream>
 #include <algorithm>
+#include <cassert>
 #include <chrono>
+#include <condition_variable>
 #include <iostream>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Computes distance fields on a worker thread, on its own copy of the crawl graph
+class FieldSpeculation
+{
+public:
+    ~FieldSpeculation()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            quit = true;
+        }
+        wake.notify_one();
+        if (worker.joinable())
+            worker.join();
+    }
+
+    // drops the unfinished and finished work and starts on the fields for these goals,
+    // the graph is only copied for the worker when it changed since the last request
+    void request(const CrawlGraph::Data& graph, const std::vector<int>& goals)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!copied || graph.version != copiedVersion)
+            {
+                jobGraph = graph;
+                hasNewGraph = true;
+                copied = true;
+                copiedVersion = graph.version;
+            }
+            jobGoals = goals;
+            results.clear();
+            job++;
+            hasJob = true;
+        }
+        if (!worker.joinable())
+            worker = std::thread(&FieldSpeculation::run, this);
+        wake.notify_one();
+    }
+
+    // stops working on the current request, keeping what is done
+    void cancel()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job++;
+        hasJob = false;
+    }
+
+    // takes the field for the goal if it is done and was computed from this version of the crawl graph, the fields
+    // from other versions are thrown away. Who is on the tiles doesn't matter, the fields only follow the crawl moves.
+    bool take(int goal, unsigned int version, AISystem::DistanceField& field)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        results.erase(std::remove_if(results.begin(), results.end(),
+            [version](const AISystem::DistanceField& result) { return result.version != version; }), results.end());
+        for (auto& result : results)
+        {
+            if (result.goal == goal)
+            {
+                std::swap(field, result);
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool quit = false;
+    bool hasJob = false;
+    unsigned int job = 0; // changes when the current work is no longer wanted
+    CrawlGraph::Data jobGraph;
+    bool hasNewGraph = false; // jobGraph is newer than the worker's copy
+    bool copied = false;
+    unsigned int copiedVersion = 0; // of the graph the worker has or is about to get
+    std::vector<int> jobGoals;
+    std::vector<AISystem::DistanceField> results;
+
+    void run()
+    {
+        CrawlGraph::Data graph;
+        std::vector<int> goals;
+        while (true)
+        {
+            unsigned int current;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this] { return quit || hasJob; });
+                if (quit)
+                    return;
+                if (hasNewGraph)
+                {
+                    std::swap(graph, jobGraph);
+                    hasNewGraph = false;
+                }
+                std::swap(goals, jobGoals);
+                hasJob = false;
+                current = job;
+            }
+            for (int goal : goals)
+            {
+                AISystem::DistanceField field;
+                int expanded;
+                AISystem::computeDistanceField(graph, goal, field, expanded);
+                std::lock_guard<std::mutex> lock(mutex);
+                if (quit || job != current)
+                    break;
+                results.push_back(std::move(field));
+            }
+        }
+    }
+};
+
+static FieldSpeculation speculation;
 
 void AISystem::step(float elapsed_ms, vec2 window_size_in_game_units)
 {
-    auto& snailEntity = ECS::registry<Snail>.entities[0];
+    ECS::Entity snailEntity = ECS::registry<Snail>.entities[0];
     float scale = TileSystem::getScale();
     
     vec2 snailPos = ECS::registry<Motion>.get(snailEntity).position;
@@ -28,405 +153,783 @@ void AISystem::step(float elapsed_ms, vec2 window_size_in_game_units)
     int yPos = (snailPos[1] - (0.5*scale))/scale;
     vec2 snailCoord = {yPos, xPos};
 
-    bool aiMovedThisStep = false;
-
     auto& aiRegistry = ECS::registry<AI>;
     if (ECS::registry<Turn>.components[0].type == ENEMY) {
-        for (unsigned int i = 0; i < aiRegistry.components.size(); i++)
+        speculation.cancel();
+        speculatedTile = -1;
+        if (!aiMoved)
         {
-            auto entity = aiRegistry.entities[i];
-            auto& tree = aiRegistry.components[i].tree;
-            tree->process(entity);
-
-            if (ECS::registry<SuperSpider>.has(entity) == true) {
-                auto& fire = ECS::registry<Fire>.get(entity);
-                if (fire.fired == true) {
-                    fire.fired = false;
-                    projectileShoot(entity);
+            if (!turnStarted)
+            {
+                queueEnemyTurn(snailCoord, window_size_in_game_units);
+                turnStarted = true;
+            }
+            // every enemy still decides from where it and the snail are at the start of the turn,
+            // whichever frame it gets to go in
+            auto begin = std::chrono::high_resolution_clock::now();
+            float used = 0.f;
+            while (turnNext < turnQueue.size())
+            {
+                ECS::Entity entity = turnQueue[turnNext++];
+                // died since the turn started
+                if (!aiRegistry.has(entity))
+                    continue;
+                auto& ai = aiRegistry.get(entity);
+                ai.tree->process(entity, ai.instance);
+
+                if (ECS::registry<SuperSpider>.has(entity) == true) {
+                    auto& fire = ECS::registry<Fire>.get(entity);
+                    if (fire.fired == true) {
+                        fire.fired = false;
+                        projectileShoot(entity);
+                    }
                 }
+                Profiler::frame.aiTicks++;
+                // at least one a frame, so the turn always ends
+                used = std::chrono::duration<float, std::micro>(std::chrono::high_resolution_clock::now() - begin).count();
+                if (used >= frameBudgetMicroseconds)
+                    break;
             }
-            aiMovedThisStep = true;
-        }
-        for (auto& entity : ECS::registry<Bird>.entities) {
-            auto& fire = ECS::registry<Fire>.get(entity);
-            if (fire.fired == true) {
-                fire.fired = false;
-                projectileShoot(entity);
+            Profiler::frame.aiMicroseconds += static_cast<int>(used);
+            Profiler::frame.aiDeferred = static_cast<int>(turnQueue.size() - turnNext);
+
+            if (turnNext >= turnQueue.size())
+            {
+                for (auto entity : ECS::registry<Bird>.entities) {
+                    auto& fire = ECS::registry<Fire>.get(entity);
+                    if (fire.fired == true) {
+                        fire.fired = false;
+                        projectileShoot(entity);
+                    }
+                }
+                aiMoved = true;
             }
         }
-        if (aiMovedThisStep)
+        else
         {
-            aiMoved = true;
+            // for the rest of the enemy turn the trees tick every frame as they always have, so RepeatForN and
+            // FireXShots keep counting frames. Only the first tick of the turn moves.
+            auto begin = std::chrono::high_resolution_clock::now();
+            for (size_t i = 0; i < aiRegistry.entities.size(); i++)
+            {
+                ECS::Entity entity = aiRegistry.entities[i];
+                auto& ai = aiRegistry.components[i];
+                ai.tree->process(entity, ai.instance);
+                Profiler::frame.aiTicks++;
+            }
+            Profiler::frame.aiMicroseconds += static_cast<int>(
+                std::chrono::duration<float, std::micro>(std::chrono::high_resolution_clock::now() - begin).count());
         }
     }
 
     if (ECS::registry<Turn>.components[0].type == PLAYER_WAITING) {
+        turnStarted = false;
         for (int i = 0; i < ECS::registry<Fire>.components.size(); i++) {
             auto& fired = ECS::registry<Fire>.components[i].fired;
             fired = true;
         }
+        // nothing else to do until the player moves, get the enemies' paths ready on the side
+        if (aiPathFindingAlgorithm == AI_PF_ALGO_DISTANCE_FIELD && aiRegistry.size() > 0)
+            speculate(snailCoord);
     }
 
 	(void)elapsed_ms; // placeholder to silence unused warning until implemented
-	(void)window_size_in_game_units; // placeholder to silence unused warning until implemented
+}
+
+void AISystem::queueEnemyTurn(vec2 snailCoord, vec2 window_size_in_game_units)
+{
+    struct Queued
+    {
+        ECS::Entity entity;
+        bool offScreen;
+        int distance; // in tiles from the snail
+    };
+    std::vector<Queued> queued;
+    float scale = TileSystem::getScale();
+    vec2 cameraOffset = Camera::getPosition();
+    auto& aiRegistry = ECS::registry<AI>;
+    for (auto entity : aiRegistry.entities)
+    {
+        vec2 aiPos = ECS::registry<Motion>.get(entity).position;
+        int xAiPos = (aiPos.x - (0.5 * scale)) / scale;
+        int yAiPos = (aiPos.y - (0.5 * scale)) / scale;
+        int distance = abs(yAiPos - static_cast<int>(snailCoord.x)) + abs(xAiPos - static_cast<int>(snailCoord.y));
+        queued.push_back({ entity, WorldSystem::offScreen(aiPos, window_size_in_game_units, cameraOffset), distance });
+    }
+    // the order only depends on the positions, never on how fast the frames are
+    std::sort(queued.begin(), queued.end(), [](const Queued& a, const Queued& b)
+    {
+        if (a.offScreen != b.offScreen)
+            return !a.offScreen;
+        if (a.distance != b.distance)
+            return a.distance < b.distance;
+        return a.entity.id < b.entity.id;
+    });
+    turnQueue.clear();
+    for (const auto& enemy : queued)
+        turnQueue.push_back(enemy.entity);
+    turnNext = 0;
+}
+
+// (row, column) of the tile a character is centred on
+static ivec2 tileOf(vec2 position)
+{
+    float scale = TileSystem::getScale();
+    return { (position.y - (0.5 * scale)) / scale, (position.x - (0.5 * scale)) / scale };
+}
+
+// shows the path when path debugging, path is (row, column) tiles
+static void drawPathDebug(const std::vector<vec2>& path)
+{
+    if (!DebugSystem::in_path_debug_mode)
+        return;
+
+    auto& tiles = TileSystem::getTiles();
+    vec2 scale = { TileSystem::getScale(), -TileSystem::getScale() };
+    auto scale_horizontal_line = scale;
+    scale_horizontal_line.y *= 0.03f;
+    auto scale_vertical_line = scale;
+    scale_vertical_line.x *= 0.03f;
+    for (size_t i = 1; i < path.size(); i++)
+    {
+        vec2 child = path[i];
+        vec2 lastVec = path[i - 1];
+        Tile& t = tiles[lastVec.x][lastVec.y];
+        if (abs(child.x-lastVec.x)>0) {
+            float scaleFac = child.x-lastVec.x > 0 ? TileSystem::getScale()/2 : -TileSystem::getScale()/2;
+            DebugSystem::createLine({t.x, t.y + scaleFac}, scale_vertical_line);
+        } else {
+            float scaleFac = child.y-lastVec.y > 0 ? TileSystem::getScale()/2 : -TileSystem::getScale()/2;
+            DebugSystem::createLine({t.x + scaleFac, t.y}, scale_horizontal_line);
+        }
+    }
+}
+
+// adds a move to a path that is built from the goal back to the start
+static void prependMove(std::vector<vec2>& reversedPath, const CrawlGraph::Move& move)
+{
+    reversedPath.push_back(vec2(CrawlGraph::tile(move.to)));
+    if (move.via >= 0)
+        reversedPath.push_back(vec2(CrawlGraph::tile(move.via)));
 }
 
 std::vector<vec2> AISystem::shortestPathBFS(vec2 start, vec2 goal, std::string animal) {
-    auto tileMovesMap = TileSystem::getAllTileMovesMap();
-    std::vector<vec2> startFrontier;
-    startFrontier.push_back(start);
-    tileMovesMap.erase(start);
-    std::deque<std::vector<vec2>> frontier = {startFrontier};
-    std::vector<vec2> current = frontier.front();
-
-  while (!frontier.empty()) {
-    current = frontier.front();
-    frontier.pop_front();
-        if (checkIfReachedDestinationOrAddNeighboringNodesToFrontier(frontier, current, tileMovesMap, goal)) {
-            return current;
+    // every tile reached, in the order it was reached, with the index of the one it was reached from.
+    // The ones after head are the frontier. Kept around to reuse the memory.
+    struct Node
+    {
+        CrawlGraph::Move move;
+        int parent;
+    };
+    static std::vector<Node> nodes;
+    static std::vector<bool> visited;
+
+    pathStats = PathStats();
+    int startTile = CrawlGraph::index(start.x, start.y);
+    int goalTile = CrawlGraph::index(goal.x, goal.y);
+    if (startTile < 0)
+        return { start };
+
+    visited.assign(CrawlGraph::rows() * CrawlGraph::columns(), false);
+    nodes.clear();
+    nodes.push_back({ { startTile, -1, startTile, CrawlGraph::WALL_MOVE }, -1 });
+    visited[startTile] = true;
+
+    for (size_t head = 0; head < nodes.size(); head++)
+    {
+        if (nodes[head].move.to == goalTile)
+        {
+            // walk back to the start
+            std::vector<vec2> path;
+            for (int i = static_cast<int>(head); i >= 0; i = nodes[i].parent)
+                prependMove(path, nodes[i].move);
+            std::reverse(path.begin(), path.end());
+            drawPathDebug(path);
+            return path;
         }
-    
-  }
-    return startFrontier;
+        pathStats.expanded++;
+
+        for (const auto& move : CrawlGraph::movesFrom(nodes[head].move.to))
+        {
+            if (visited[move.to])
+                continue;
+            nodes.push_back({ move, static_cast<int>(head) });
+            if (move.visits >= 0)
+                visited[move.visits] = true;
+        }
+    }
+    return { start };
 }
 
+// Binary min-heap of tile indices ordered by estimated path length, that can lower the estimate of a tile already in it
+class TileHeap
+{
+public:
+    int operations = 0;
+
+    void reset(size_t tiles)
+    {
+        heap.clear();
+        position.assign(tiles, -1);
+        operations = 0;
+    }
+
+    bool empty() const { return heap.empty(); }
+
+    // add the tile, or move it up if it's already in the heap with a larger estimate
+    void update(int tile, int estimate, int remaining)
+    {
+        operations++;
+        int i = position[tile];
+        if (i < 0)
+        {
+            i = static_cast<int>(heap.size());
+            heap.push_back({ tile, estimate, remaining });
+            position[tile] = i;
+        }
+        else
+        {
+            heap[i].estimate = estimate;
+            heap[i].remaining = remaining;
+        }
+        siftUp(i);
+    }
+
+    int pop()
+    {
+        operations++;
+        int tile = heap[0].tile;
+        position[tile] = -1;
+        heap[0] = heap.back();
+        heap.pop_back();
+        if (!heap.empty())
+        {
+            position[heap[0].tile] = 0;
+            siftDown(0);
+        }
+        return tile;
+    }
+
+private:
+    struct Entry
+    {
+        int tile;
+        int estimate;
+        int remaining;
+    };
+    std::vector<Entry> heap;
+    // where each tile is in the heap, -1 if it isn't
+    std::vector<int> position;
+
+    // ties go to the one closer to the goal
+    static bool before(const Entry& a, const Entry& b)
+    {
+        return a.estimate < b.estimate || (a.estimate == b.estimate && a.remaining < b.remaining);
+    }
+
+    void swap(int i, int j)
+    {
+        std::swap(heap[i], heap[j]);
+        position[heap[i].tile] = i;
+        position[heap[j].tile] = j;
+    }
+
+    void siftUp(int i)
+    {
+        while (i > 0 && before(heap[i], heap[(i - 1) / 2]))
+        {
+            swap(i, (i - 1) / 2);
+            i = (i - 1) / 2;
+        }
+    }
+
+    void siftDown(int i)
+    {
+        int size = static_cast<int>(heap.size());
+        while (true)
+        {
+            int smallest = i;
+            int left = 2 * i + 1;
+            int right = left + 1;
+            if (left < size && before(heap[left], heap[smallest]))
+                smallest = left;
+            if (right < size && before(heap[right], heap[smallest]))
+                smallest = right;
+            if (smallest == i)
+                return;
+            swap(i, smallest);
+            i = smallest;
+        }
+    }
+};
+
 std::vector<vec2> AISystem::shortestPathAStar(vec2 start, vec2 goal, std::string animal) {
-    auto tileMovesMap = TileSystem::getAllTileMovesMap();
-    std::vector<vec2> startFrontier;
-    startFrontier.push_back(start);
-    tileMovesMap.erase(start);
-    std::deque<std::vector<vec2>> frontier = {startFrontier};
-    std::vector<vec2> current = frontier.front();
-
-  while (!frontier.empty()) {
-    current = frontier.front();
-    frontier.pop_front();
-        //std::cout << "call to SPIDER" << std::endl;
-        if (checkIfReachedDestinationOrAddNeighboringNodesToFrontier(frontier, current, tileMovesMap, goal)) {
-            //std::cout << "about to return path" << std::endl;
-            return current;
-        }
-    sortQueue(frontier, goal);
-  }
-  return startFrontier;
+    // per tile, kept around to reuse the memory
+    static std::vector<int> cost; // path length from the start
+    static std::vector<int> cameFrom;
+    static std::vector<CrawlGraph::Move> reachedBy;
+    static std::vector<bool> closed;
+    static TileHeap open;
+
+    pathStats = PathStats();
+    int startTile = CrawlGraph::index(start.x, start.y);
+    int goalTile = CrawlGraph::index(goal.x, goal.y);
+    if (startTile < 0)
+        return { start };
+
+    ivec2 goalCoord(goal);
+    // every step moves one tile, so the manhattan distance never overestimates
+    auto heuristic = [&goalCoord](int tile)
+    {
+        ivec2 coord = CrawlGraph::tile(tile);
+        return abs(coord.x - goalCoord.x) + abs(coord.y - goalCoord.y);
+    };
+
+    size_t tiles = CrawlGraph::rows() * CrawlGraph::columns();
+    cost.assign(tiles, std::numeric_limits<int>::max());
+    cameFrom.resize(tiles);
+    reachedBy.resize(tiles);
+    closed.assign(tiles, false);
+    open.reset(tiles);
+
+    cost[startTile] = 0;
+    cameFrom[startTile] = -1;
+    reachedBy[startTile] = { startTile, -1, startTile, CrawlGraph::WALL_MOVE };
+    open.update(startTile, heuristic(startTile), heuristic(startTile));
+
+    while (!open.empty())
+    {
+        int current = open.pop();
+        if (current == goalTile)
+        {
+            // walk back to the start
+            std::vector<vec2> path;
+            for (int i = current; i >= 0; i = cameFrom[i])
+                prependMove(path, reachedBy[i]);
+            std::reverse(path.begin(), path.end());
+            pathStats.heapOperations = open.operations;
+            drawPathDebug(path);
+            return path;
+        }
+        closed[current] = true;
+        pathStats.expanded++;
+
+        for (const auto& move : CrawlGraph::movesFrom(current))
+        {
+            if (closed[move.to])
+                continue;
+            // corner moves pass through two tiles
+            int nextCost = cost[current] + (move.via >= 0 ? 2 : 1);
+            if (nextCost >= cost[move.to])
+                continue;
+            cost[move.to] = nextCost;
+            cameFrom[move.to] = current;
+            reachedBy[move.to] = move;
+            int remaining = heuristic(move.to);
+            open.update(move.to, nextCost + remaining, remaining);
+        }
+    }
+    pathStats.heapOperations = open.operations;
+    return { start };
 }
-  
 
-void AISystem::sortQueue(std::deque<std::vector<vec2>> &frontier, vec2 destCoord)
+// the only move out of a tile other than going back to where it was entered from, null if there are none or several
+static const CrawlGraph::Move* corridorMove(int tile, int from)
 {
-    std::vector<std::vector<vec2>> list;
-    std::vector<vec2> current;
-    while (!frontier.empty()) {
-      current = frontier.front();
-      frontier.pop_front();
-      list.push_back(current);
-    }
-    
-    sort(list.begin(), list.end(), FrontierComparator(destCoord));
-    
-    for (auto& item : list) {
-        frontier.push_back(item);
+    const CrawlGraph::Move* onward = nullptr;
+    for (const auto& move : CrawlGraph::movesFrom(tile))
+    {
+        if (move.to == from)
+            continue;
+        if (onward)
+            return nullptr;
+        onward = &move;
     }
+    return onward;
 }
 
-bool AISystem::checkIfReachedDestinationOrAddNeighboringNodesToFrontier(std::deque<std::vector<vec2>>& frontier, std::vector<vec2>& current, TileSystem::vec2Map& tileMovesMap, vec2& goal) {
-    auto tiles = TileSystem::getTiles();
+std::vector<vec2> AISystem::shortestPathJPS(vec2 start, vec2 goal, std::string animal) {
+    // per tile, kept around to reuse the memory
+    static std::vector<int> cost; // path length from the start
+    static std::vector<int> cameFrom; // the tile the jump here started from
+    static std::vector<CrawlGraph::Move> jumpedBy; // the first move of that jump
+    static std::vector<bool> closed;
+    static TileHeap open;
 
-    if (current[current.size()-1] == goal) {
-        vec2 lastVec;
-        int counter = 0;
-        for (vec2 child : current) {
-            
-            if (DebugSystem::in_path_debug_mode && counter != 0)
-            {
-                vec2 scale = { TileSystem::getScale(), -TileSystem::getScale() };
-                auto scale_horizontal_line = scale;
-                scale_horizontal_line.y *= 0.03f;
-                auto scale_vertical_line = scale;
-                scale_vertical_line.x *= 0.03f;
-                if (abs(child.x-lastVec.x)>0) {
-                    float scaleFac = child.x-lastVec.x > 0 ? TileSystem::getScale()/2 : -TileSystem::getScale()/2;
-                    Tile t = tiles[lastVec.x][lastVec.y];
-                    DebugSystem::createLine({t.x, t.y + scaleFac}, scale_vertical_line);
-                } else {
-                    float scaleFac = child.y-lastVec.y > 0 ? TileSystem::getScale()/2 : -TileSystem::getScale()/2;
-                    Tile t = tiles[lastVec.x][lastVec.y];
-                    DebugSystem::createLine({t.x + scaleFac, t.y}, scale_horizontal_line);
-                }
-            }
-                
-            counter++;
-            lastVec = child;
-            
+    pathStats = PathStats();
+    int startTile = CrawlGraph::index(start.x, start.y);
+    int goalTile = CrawlGraph::index(goal.x, goal.y);
+    if (startTile < 0)
+        return { start };
+
+    ivec2 goalCoord(goal);
+    // every step moves one tile, so the manhattan distance never overestimates
+    auto heuristic = [&goalCoord](int tile)
+    {
+        ivec2 coord = CrawlGraph::tile(tile);
+        return abs(coord.x - goalCoord.x) + abs(coord.y - goalCoord.y);
+    };
+
+    int tiles = CrawlGraph::rows() * CrawlGraph::columns();
+    cost.assign(tiles, std::numeric_limits<int>::max());
+    cameFrom.resize(tiles);
+    jumpedBy.resize(tiles);
+    closed.assign(tiles, false);
+    open.reset(tiles);
+
+    cost[startTile] = 0;
+    cameFrom[startTile] = -1;
+    open.update(startTile, heuristic(startTile), heuristic(startTile));
+
+    // Follows a move and keeps going while there is only one way on, like along a flat wall, calling back with
+    // every move taken. Tiles on the way don't need to go in the heap: the only shortest paths through them lead on
+    // to where the jump stops, at the goal or where the moves branch.
+    auto jump = [tiles, goalTile](int origin, const CrawlGraph::Move& first, auto taken)
+    {
+        int from = origin;
+        const CrawlGraph::Move* move = &first;
+        taken(*move);
+        // a run can loop back around a block
+        for (int steps = 0; move->to != goalTile && move->to != origin && steps < tiles; steps++)
+        {
+            const CrawlGraph::Move* onward = corridorMove(move->to, from);
+            if (!onward)
+                break;
+            from = move->to;
+            move = onward;
+            taken(*move);
         }
-        //std::cout << "on true" << std::endl;
-        return true;
-    }
-    else {
-        vec2 endNode = current[current.size() - 1];
-        std::vector<vec2> next = current;
-
-        // wall above
-        if(endNode.x-1 >= 0 && endNode.x-1 < tiles.size() && endNode.y >= 0 && endNode.y < tiles[endNode.x-1].size() && tiles[endNode.x-1][endNode.y].type == WALL) {
-            
-            if (tileMovesMap.find({endNode.x-1, endNode.y-1}) != tileMovesMap.end()) {
-                if(tiles[endNode.x][endNode.y-1].type == EMPTY) {
-                    next.push_back({endNode.x, endNode.y-1});
-                    next.push_back({endNode.x-1, endNode.y-1});
-                    frontier.push_back(next);
-                    next = current;
-                    tileMovesMap.erase({endNode.x-1, endNode.y-1});
-                }
-            }
-            if (tileMovesMap.find({endNode.x-1, endNode.y+1}) != tileMovesMap.end()) {
-                if(tiles[endNode.x][endNode.y+1].type == EMPTY) {
-                    next.push_back({endNode.x, endNode.y+1});
-                    next.push_back({endNode.x-1, endNode.y+1});
-                    frontier.push_back(next);
-                    next = current;
-                    tileMovesMap.erase({endNode.x-1, endNode.y+1});
-                }
-            }
-            
-            // left tile
-            if (tileMovesMap.find({endNode.x, endNode.y-1}) != tileMovesMap.end()) {
-                if(tiles[endNode.x-1][endNode.y-1].type == WALL) {
-                    next.push_back({endNode.x, endNode.y-1});
-                    frontier.push_back(next);
-                    next = current;
-                    tileMovesMap.erase({endNode.x, endNode.y-1});
-                }
-            }
-            
-            // right tile
-            if (tileMovesMap.find({endNode.x, endNode.y+1}) != tileMovesMap.end()) {
-                if(tiles[endNode.x-1][endNode.y+1].type == WALL) {
-                    next.push_back({endNode.x, endNode.y+1});
-                    frontier.push_back(next);
-                    next = current;
-                    tileMovesMap.erase({endNode.x, endNode.y+1});
-                }
-            }
-            
-        }
-        // wall on the right
-        if(endNode.x >= 0 && endNode.x < tiles.size() && endNode.y+1 >= 0 && endNode.y+1 < tiles[endNode.x].size() && tiles[endNode.x][endNode.y+1].type == WALL) {
-            if (tileMovesMap.find({endNode.x+1, endNode.y+1}) != tileMovesMap.end()) {
-                if(tiles[endNode.x+1][endNode.y].type == EMPTY) {
-                    next.push_back({endNode.x+1, endNode.y});
-                    next.push_back({endNode.x+1, endNode.y+1});
-                    frontier.push_back(next);
-                    next = current;
-                    tileMovesMap.erase({endNode.x+1, endNode.y+1});
-                }
-            }
-            if (tileMovesMap.find({endNode.x-1, endNode.y+1}) != tileMovesMap.end()) {
-                if(tiles[endNode.x-1][endNode.y].type == EMPTY) {
-                    next.push_back({endNode.x-1, endNode.y});
-                    next.push_back({endNode.x-1, endNode.y+1});
-                    frontier.push_back(next);
-                    next = current;
-                    tileMovesMap.erase({endNode.x-1, endNode.y+1});
-                }
-            }
-            // up tile
-            if (tileMovesMap.find({endNode.x-1, endNode.y}) != tileMovesMap.end()) {
-                if(tiles[endNode.x-1][endNode.y+1].type == WALL) {
-                    next.push_back({endNode.x-1, endNode.y});
-                    frontier.push_back(next);
-                    next = current;
-                    tileMovesMap.erase({endNode.x-1, endNode.y});
-                }
-            }
-            
-            // down tile
-            if (tileMovesMap.find({endNode.x+1, endNode.y}) != tileMovesMap.end()) {
-                if(tiles[endNode.x+1][endNode.y+1].type == WALL) {
-                    next.push_back({endNode.x+1, endNode.y});
-                    frontier.push_back(next);
-                    next = current;
-                    tileMovesMap.erase({endNode.x+1, endNode.y});
-                }
+        return move->to;
+    };
+
+    while (!open.empty())
+    {
+        int current = open.pop();
+        if (current == goalTile)
+        {
+            // the jumps back to the start, then every move along them
+            std::vector<int> jumps;
+            for (int i = current; i >= 0; i = cameFrom[i])
+                jumps.push_back(i);
+            std::vector<vec2> path = { start };
+            for (size_t i = jumps.size() - 1; i > 0; i--)
+            {
+                jump(jumps[i], jumpedBy[jumps[i - 1]], [&path](const CrawlGraph::Move& move)
+                {
+                    if (move.via >= 0)
+                        path.push_back(vec2(CrawlGraph::tile(move.via)));
+                    path.push_back(vec2(CrawlGraph::tile(move.to)));
+                });
             }
+            pathStats.heapOperations = open.operations;
+            drawPathDebug(path);
+            return path;
         }
-        // wall on the left
-        if(endNode.x >= 0 && endNode.x < tiles.size() && endNode.y-1 >= 0 && endNode.y-1 < tiles[endNode.x].size() && tiles[endNode.x][endNode.y-1].type == WALL) {
-            if (tileMovesMap.find({endNode.x-1, endNode.y-1}) != tileMovesMap.end()) {
-                if(tiles[endNode.x-1][endNode.y].type == EMPTY) {
-                    next.push_back({endNode.x-1, endNode.y});
-                    next.push_back({endNode.x-1, endNode.y-1});
-                    frontier.push_back(next);
-                    next = current;
-                    tileMovesMap.erase({endNode.x-1, endNode.y-1});
-                }
-            }
-            if (tileMovesMap.find({endNode.x+1, endNode.y-1}) != tileMovesMap.end()) {
-                if(tiles[endNode.x+1][endNode.y].type == EMPTY) {
-                    next.push_back({endNode.x+1, endNode.y});
-                    next.push_back({endNode.x+1, endNode.y-1});
-                    frontier.push_back(next);
-                    next = current;
-                    tileMovesMap.erase({endNode.x+1, endNode.y-1});
-                }
-            }
-            
-            // up tile
-            if (tileMovesMap.find({endNode.x-1, endNode.y}) != tileMovesMap.end()) {
-                if(tiles[endNode.x-1][endNode.y-1].type == WALL) {
-                    next.push_back({endNode.x-1, endNode.y});
-                    frontier.push_back(next);
-                    next = current;
-                    tileMovesMap.erase({endNode.x-1, endNode.y});
-                }
-            }
-            
-            // down tile
-            if (tileMovesMap.find({endNode.x+1, endNode.y}) != tileMovesMap.end()) {
-                if(tiles[endNode.x+1][endNode.y-1].type == WALL) {
-                    next.push_back({endNode.x+1, endNode.y});
-                    frontier.push_back(next);
-                    next = current;
-                    tileMovesMap.erase({endNode.x+1, endNode.y});
-                }
-            }
+        closed[current] = true;
+        pathStats.expanded++;
+
+        for (const auto& move : CrawlGraph::movesFrom(current))
+        {
+            int length = 0;
+            int landing = jump(current, move, [&length](const CrawlGraph::Move& taken)
+            {
+                // corner moves pass through two tiles
+                length += taken.via >= 0 ? 2 : 1;
+            });
+            if (closed[landing])
+                continue;
+            int nextCost = cost[current] + length;
+            if (nextCost >= cost[landing])
+                continue;
+            cost[landing] = nextCost;
+            cameFrom[landing] = current;
+            jumpedBy[landing] = move;
+            int remaining = heuristic(landing);
+            open.update(landing, nextCost + remaining, remaining);
         }
-        // wall below
-        if(endNode.x+1 >= 0 && endNode.x+1 < tiles.size() && endNode.y >= 0 && endNode.y < tiles[endNode.x+1].size() && tiles[endNode.x+1][endNode.y].type == WALL) {
-            if (tileMovesMap.find({endNode.x+1, endNode.y+1}) != tileMovesMap.end()) {
-                if(tiles[endNode.x][endNode.y+1].type == EMPTY) {
-                    next.push_back({endNode.x, endNode.y+1});
-                    next.push_back({endNode.x+1, endNode.y+1});
-                    frontier.push_back(next);
-                    next = current;
-                    tileMovesMap.erase({endNode.x+1, endNode.y-1});
-                }
-            }
-            if (tileMovesMap.find({endNode.x+1, endNode.y-1}) != tileMovesMap.end()) {
-                if(tiles[endNode.x][endNode.y-1].type == EMPTY) {
-                    next.push_back({endNode.x, endNode.y-1});
-                    next.push_back({endNode.x+1, endNode.y-1});
-                    frontier.push_back(next);
-                    next = current;
-                    tileMovesMap.erase({endNode.x+1, endNode.y-1});
-                }
-            }
-            // left tile
-            if (tileMovesMap.find({endNode.x, endNode.y-1}) != tileMovesMap.end()) {
-                if(tiles[endNode.x+1][endNode.y-1].type == WALL) {
-                    next.push_back({endNode.x, endNode.y-1});
-                    frontier.push_back(next);
-                    next = current;
-                    tileMovesMap.erase({endNode.x, endNode.y-1});
-                }
-            }
-            
-            // right tile
-            if (tileMovesMap.find({endNode.x, endNode.y+1}) != tileMovesMap.end()) {
-                if(tiles[endNode.x+1][endNode.y+1].type == WALL) {
-                    next.push_back({endNode.x, endNode.y+1});
-                    frontier.push_back(next);
-                    next = current;
-                    tileMovesMap.erase({endNode.x, endNode.y+1});
-                }
+    }
+    pathStats.heapOperations = open.operations;
+    return { start };
+}
+
+std::vector<vec2> AISystem::shortestPathHPA(vec2 start, vec2 goal, std::string animal) {
+    pathStats = PathStats();
+    int startTile = CrawlGraph::index(start.x, start.y);
+    if (startTile < 0)
+        return { start };
+    std::vector<vec2> path = CrawlClusters::findPath(startTile, CrawlGraph::index(goal.x, goal.y), pathStats.expanded);
+    drawPathDebug(path);
+    return path;
+}
+
+void AISystem::computeDistanceField(const CrawlGraph::Data& graph, int goalTile, DistanceField& field, int& expanded)
+{
+    // the moves into each tile, as compressed rows like the graph.
+    // Kept around to reuse the memory, per thread since the speculation runs this too.
+    struct ReverseMove
+    {
+        int from;
+        int cost;
+    };
+    thread_local static std::vector<int> reverseOffsets;
+    thread_local static std::vector<ReverseMove> reverseMoves;
+    thread_local static std::vector<int> cursor;
+    thread_local static TileHeap open;
+
+    int tiles = graph.rowCount * graph.columnCount;
+    reverseOffsets.assign(tiles + 1, 0);
+    for (int tile = 0; tile < tiles; tile++)
+    {
+        for (const auto& move : graph.movesFrom(tile))
+            reverseOffsets[move.to + 1]++;
+    }
+    for (int tile = 0; tile < tiles; tile++)
+        reverseOffsets[tile + 1] += reverseOffsets[tile];
+    reverseMoves.resize(reverseOffsets[tiles]);
+    cursor.assign(reverseOffsets.begin(), reverseOffsets.end() - 1);
+    for (int tile = 0; tile < tiles; tile++)
+    {
+        for (const auto& move : graph.movesFrom(tile))
+            reverseMoves[cursor[move.to]++] = { tile, move.via >= 0 ? 2 : 1 };
+    }
+
+    // dijkstra backwards from the goal
+    auto& distance = field.distance;
+    distance.assign(tiles, std::numeric_limits<int>::max());
+    open.reset(tiles);
+    expanded = 0;
+    if (goalTile >= 0)
+    {
+        distance[goalTile] = 0;
+        open.update(goalTile, 0, 0);
+    }
+    while (!open.empty())
+    {
+        int current = open.pop();
+        expanded++;
+        for (int i = reverseOffsets[current]; i < reverseOffsets[current + 1]; i++)
+        {
+            const ReverseMove& move = reverseMoves[i];
+            int next = distance[current] + move.cost;
+            if (next < distance[move.from])
+            {
+                distance[move.from] = next;
+                open.update(move.from, next, 0);
             }
         }
-        
-        
-        // INDIVIDUAL //
-        
-        // left vine tile
-        if (tileMovesMap.find({endNode.x, endNode.y-1}) != tileMovesMap.end()) {
-            if(tiles[endNode.x][endNode.y-1].type == VINE) {
-                next.push_back({endNode.x, endNode.y-1});
-                frontier.push_back(next);
-                next = current;
-                tileMovesMap.erase({endNode.x, endNode.y-1});
-            }
+    }
+    field.goal = goalTile;
+    field.version = graph.version;
+}
+
+void AISystem::speculate(vec2 snailCoord)
+{
+    // already working on this
+    int snailTile = CrawlGraph::index(snailCoord.x, snailCoord.y);
+    if (snailTile == speculatedTile && CrawlGraph::version() == speculatedVersion)
+        return;
+    speculatedTile = snailTile;
+    speculatedVersion = CrawlGraph::version();
+    if (snailTile < 0)
+        return;
+
+    // where the snail can be at the start of the enemy turn: staying, one move in any direction, around a corner,
+    // or falling
+    auto& tiles = TileSystem::getTiles();
+    int row = snailCoord.x;
+    int col = snailCoord.y;
+    std::vector<int> goals = { snailTile };
+    ivec2 neighbours[] = { { row, col - 1 }, { row, col + 1 }, { row - 1, col }, { row + 1, col } };
+    for (ivec2 neighbour : neighbours)
+    {
+        int tile = CrawlGraph::index(neighbour.x, neighbour.y);
+        if (tile >= 0)
+            goals.push_back(tile);
+    }
+    for (const auto& move : CrawlGraph::movesFrom(snailTile))
+    {
+        if (std::find(goals.begin(), goals.end(), move.to) == goals.end())
+            goals.push_back(move.to);
+    }
+    int landing = row;
+    while (landing + 1 < static_cast<int>(tiles.size()) && col < static_cast<int>(tiles[landing + 1].size()) && tiles[landing + 1][col].type == EMPTY)
+        landing++;
+    if (landing != row && landing != row + 1)
+        goals.push_back(CrawlGraph::index(landing, col));
+
+    speculation.request(CrawlGraph::data(), goals);
+}
+
+std::vector<vec2> AISystem::pathFromSnailDistanceField(vec2 start, vec2 goal)
+{
+    pathStats = PathStats();
+    int startTile = CrawlGraph::index(start.x, start.y);
+    int goalTile = CrawlGraph::index(goal.x, goal.y);
+    // the field only follows the crawl moves, enemies moving onto other tiles while the turn is spread over frames
+    // don't change it
+    if (snailField.goal != goalTile || snailField.version != CrawlGraph::version() || snailField.distance.empty())
+    {
+        auto begin = std::chrono::high_resolution_clock::now();
+        // computed while the player was deciding, if they went where we guessed and nothing changed since
+        bool speculated = speculation.take(goalTile, CrawlGraph::version(), snailField);
+        int expanded = 0;
+        if (speculated)
+            Profiler::frame.fieldsSpeculated++;
+        else
+        {
+            computeDistanceField(CrawlGraph::data(), goalTile, snailField, expanded);
+            Profiler::frame.fieldsComputed++;
         }
-        
-        // right vine tile
-        if (tileMovesMap.find({endNode.x, endNode.y+1}) != tileMovesMap.end()) {
-            if(tiles[endNode.x][endNode.y+1].type == VINE) {
-                next.push_back({endNode.x, endNode.y+1});
-                frontier.push_back(next);
-                next = current;
-                tileMovesMap.erase({endNode.x, endNode.y+1});
-            }
+        if (DebugSystem::in_path_debug_mode) {
+            auto duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - begin);
+            std::cout << "Distance field to the snail: " << duration.count() << " microseconds, "
+                << (speculated ? "computed in advance" : std::to_string(expanded) + " nodes expanded") << std::endl;
         }
-        
-        // up vine tile
-        if (tileMovesMap.find({endNode.x-1, endNode.y}) != tileMovesMap.end()) {
-            if(tiles[endNode.x-1][endNode.y].type == VINE) {
-                next.push_back({endNode.x-1, endNode.y});
-                frontier.push_back(next);
-                next = current;
-                tileMovesMap.erase({endNode.x-1, endNode.y});
+    }
+    auto& distance = snailField.distance;
+    if (startTile < 0 || distance[startTile] == std::numeric_limits<int>::max())
+        return { start };
+
+    // downhill, every tile on the way has a move that is exactly its distance shorter
+    std::vector<vec2> path = { start };
+    int current = startTile;
+    while (distance[current] > 0)
+    {
+        for (const auto& move : CrawlGraph::movesFrom(current))
+        {
+            int cost = move.via >= 0 ? 2 : 1;
+            if (distance[move.to] != std::numeric_limits<int>::max() && distance[move.to] + cost == distance[current])
+            {
+                if (move.via >= 0)
+                    path.push_back(vec2(CrawlGraph::tile(move.via)));
+                path.push_back(vec2(CrawlGraph::tile(move.to)));
+                current = move.to;
+                break;
             }
         }
-        
-        // down vine tile
-        if (tileMovesMap.find({endNode.x+1, endNode.y}) != tileMovesMap.end()) {
-            if(tiles[endNode.x+1][endNode.y].type == VINE) {
-                next.push_back({endNode.x+1, endNode.y});
-                frontier.push_back(next);
-                next = current;
-                tileMovesMap.erase({endNode.x+1, endNode.y});
+    }
+    drawPathDebug(path);
+    return path;
+}
+
+// The last paths found, keyed by where they go from and to, the algorithm, who is moving and the tile grid they were
+// found on. The grid version changes with any tile, so an entry never outlives the grid it was found on.
+class PathCache
+{
+public:
+    static const size_t CAPACITY = 32;
+
+    // the cached path, or for the shortest path algorithms the rest of a cached path to the same goal that passes the start
+    bool find(ivec2 start, ivec2 goal, const std::string& algorithm, const std::string& animal, unsigned int version, std::vector<vec2>& path)
+    {
+        // the BFS and HPA paths aren't always the shortest, the rest of one can differ from a search from there
+        bool shortest = algorithm == AI_PF_ALGO_A_STAR || algorithm == AI_PF_ALGO_JPS || algorithm == AI_PF_ALGO_DISTANCE_FIELD;
+        Entry* passing = nullptr;
+        size_t passingAt = 0;
+        for (auto& entry : entries)
+        {
+            if (entry.goal != goal || entry.version != version || entry.algorithm != algorithm || entry.animal != animal)
+                continue;
+            if (entry.start == start)
+            {
+                entry.lastUsed = ++uses;
+                path = entry.path;
+                Profiler::frame.pathCacheHits++;
+                return true;
             }
-        }
-        
-        // CURRENT VINE TILE
-        
-        // left vine tile
-        if (tileMovesMap.find({endNode.x, endNode.y-1}) != tileMovesMap.end()) {
-            if(tiles[endNode.x][endNode.y].type == VINE && (tiles[endNode.x+1][endNode.y-1].type == WALL || tiles[endNode.x-1][endNode.y-1].type == WALL)) {
-                next.push_back({endNode.x, endNode.y-1});
-                frontier.push_back(next);
-                next = current;
-                tileMovesMap.erase({endNode.x, endNode.y-1});
+            // a shortest path is still the shortest from any tile along it, which is where the enemy that asked
+            // for it is after following it for a few turns
+            for (size_t i = 1; shortest && !passing && i < entry.path.size(); i++)
+            {
+                if (ivec2(entry.path[i]) == start)
+                {
+                    passing = &entry;
+                    passingAt = i;
+                }
             }
         }
-        
-        // right vine tile
-        if (tileMovesMap.find({endNode.x, endNode.y+1}) != tileMovesMap.end()) {
-            if(tiles[endNode.x][endNode.y].type == VINE && (tiles[endNode.x-1][endNode.y+1].type == WALL || tiles[endNode.x+1][endNode.y+1].type == WALL)) {
-                next.push_back({endNode.x, endNode.y+1});
-                frontier.push_back(next);
-                next = current;
-                tileMovesMap.erase({endNode.x, endNode.y+1});
-            }
+        if (!passing)
+        {
+            Profiler::frame.pathCacheMisses++;
+            return false;
         }
-        
-        // up vine tile
-        if (tileMovesMap.find({endNode.x-1, endNode.y}) != tileMovesMap.end()) {
-            if(tiles[endNode.x][endNode.y].type == VINE && (tiles[endNode.x-1][endNode.y-1].type == WALL || tiles[endNode.x-1][endNode.y+1].type == WALL)) {
-                next.push_back({endNode.x-1, endNode.y});
-                frontier.push_back(next);
-                next = current;
-                tileMovesMap.erase({endNode.x-1, endNode.y});
-            }
+        passing->lastUsed = ++uses;
+        path.assign(passing->path.begin() + passingAt, passing->path.end());
+        Profiler::frame.pathCacheRepairs++;
+        add(start, goal, algorithm, animal, version, path);
+        return true;
+    }
+
+    // replaces the least recently used entry once full
+    void add(ivec2 start, ivec2 goal, const std::string& algorithm, const std::string& animal, unsigned int version, const std::vector<vec2>& path)
+    {
+        Entry* slot = nullptr;
+        if (entries.size() < CAPACITY)
+        {
+            entries.emplace_back();
+            slot = &entries.back();
         }
-        
-        // down vine tile
-        if (tileMovesMap.find({endNode.x+1, endNode.y}) != tileMovesMap.end()) {
-            if(tiles[endNode.x][endNode.y].type == VINE && (tiles[endNode.x+1][endNode.y-1].type == WALL || tiles[endNode.x+1][endNode.y+1].type == WALL)) {
-                next.push_back({endNode.x+1, endNode.y});
-                frontier.push_back(next);
-                next = current;
-                tileMovesMap.erase({endNode.x+1, endNode.y});
-            }
+        else
+        {
+            slot = &*std::min_element(entries.begin(), entries.end(),
+                [](const Entry& a, const Entry& b) { return a.lastUsed < b.lastUsed; });
         }
-        
+        *slot = { start, goal, algorithm, animal, version, path, ++uses };
     }
-    //std::cout << "on false" << std::endl;
-    return false;
 
+private:
+    struct Entry
+    {
+        ivec2 start;
+        ivec2 goal;
+        std::string algorithm;
+        std::string animal;
+        unsigned int version;
+        std::vector<vec2> path;
+        unsigned int lastUsed;
+    };
+    std::vector<Entry> entries;
+    unsigned int uses = 0;
+};
+
+static PathCache pathCache;
+
+std::vector<vec2> AISystem::findPath(vec2 start, vec2 goal, std::string animal)
+{
+    std::vector<vec2> path;
+    unsigned int version = TileSystem::getGridVersion();
+    if (pathCache.find(ivec2(start), ivec2(goal), aiPathFindingAlgorithm, animal, version, path))
+    {
+        pathStats = PathStats();
+        drawPathDebug(path);
+        return path;
+    }
+
+    if (aiPathFindingAlgorithm == AI_PF_ALGO_A_STAR) {
+        path = shortestPathAStar(start, goal, animal);
+    }
+    else if (aiPathFindingAlgorithm == AI_PF_ALGO_DISTANCE_FIELD) {
+        // every enemy heads for the snail, so they share one field of shortest distances to it instead of each searching
+        path = pathFromSnailDistanceField(start, goal);
+    }
+    else if (aiPathFindingAlgorithm == AI_PF_ALGO_JPS) {
+        path = shortestPathJPS(start, goal, animal);
+    }
+    else if (aiPathFindingAlgorithm == AI_PF_ALGO_HPA) {
+        path = shortestPathHPA(start, goal, animal);
+    }
+    else {
+        path = shortestPathBFS(start, goal, animal);
+    }
+    pathCache.add(ivec2(start), ivec2(goal), aiPathFindingAlgorithm, animal, version, path);
+    return path;
 }
 
 void AISystem::projectileShoot(ECS::Entity& e) {
 
     // range of bird firing, don't want him to fire if he is off the screen.
     if (ECS::registry<Bird>.has(e)) {
-        auto& snailEntity = ECS::registry<Snail>.entities[0];
+        ECS::Entity snailEntity = ECS::registry<Snail>.entities[0];
         float scale = TileSystem::getScale();
 
         vec2 snailPos = ECS::registry<Motion>.get(snailEntity).position;
@@ -434,7 +937,6 @@ void AISystem::projectileShoot(ECS::Entity& e) {
         int yPos = (snailPos[1] - (0.5 * scale)) / scale;
         vec2 snailCoord = { yPos, xPos };
 
-        auto tiles = TileSystem::getTiles();
         auto& motion = ECS::registry<Motion>.get(e);
         vec2 aiPos = motion.position;
         int xAiPos = (aiPos.x - (0.5 * scale)) / scale;
@@ -453,13 +955,17 @@ void AISystem::projectileShoot(ECS::Entity& e) {
 
     vec2 birdPosition = ECS::registry<Motion>.get(e).position;
 
-    auto& snailEntity = ECS::registry<Snail>.entities[0];
+    ECS::Entity snailEntity = ECS::registry<Snail>.entities[0];
 
     // now you want to go in the direction of the (mouse_pos - snail_pos), but make it a unit vector
     vec2 snailPosition = ECS::registry<Motion>.get(snailEntity).position;
     if (birdPosition == snailPosition) {
         return;
     }
+    // a shot into a wall would only bounce back
+    if (!Visibility::canSee(tileOf(birdPosition), tileOf(snailPosition))) {
+        return;
+    }
     vec2 normal = normalize(snailPosition - birdPosition);
     float factor = 0.50f * TileSystem::getScale();
     vec2 offset = factor * normal;
@@ -476,10 +982,10 @@ void AISystem::projectileShoot(ECS::Entity& e) {
     }
 }
 
-BTState LookForSnail::process(ECS::Entity e) {
+static BTState lookForSnail(ECS::Entity e, bool inRange) {
     //std::cout << "in look for snail" << std::endl;
     // before for loop
-    auto& snailEntity = ECS::registry<Snail>.entities[0];
+    ECS::Entity snailEntity = ECS::registry<Snail>.entities[0];
     float scale = TileSystem::getScale();
 
     vec2 snailPos = ECS::registry<Motion>.get(snailEntity).position;
@@ -490,7 +996,6 @@ BTState LookForSnail::process(ECS::Entity e) {
     // after for loop
     auto entity = e;
 
-    auto tiles = TileSystem::getTiles();
     auto& motion = ECS::registry<Motion>.get(entity);
     vec2 aiPos = motion.position;
     int xAiPos = (aiPos.x - (0.5 * scale)) / scale;
@@ -500,13 +1005,7 @@ BTState LookForSnail::process(ECS::Entity e) {
 
     auto start = std::chrono::high_resolution_clock::now();
 
-
-    if (AISystem::aiPathFindingAlgorithm == AI_PF_ALGO_A_STAR) {
-        current = AISystem::shortestPathAStar(aiCoord, snailCoord, "spider");
-    }
-    else {
-        current = AISystem::shortestPathBFS(aiCoord, snailCoord, "spider");
-    }
+    current = AISystem::findPath(aiCoord, snailCoord, "spider");
     // Get ending timepoint
     auto stop = std::chrono::high_resolution_clock::now();
 
@@ -517,7 +1016,9 @@ BTState LookForSnail::process(ECS::Entity e) {
 
     if (DebugSystem::in_path_debug_mode) {
         std::cout << "Time taken by function: "
-            << duration.count() << " microseconds" << std::endl;
+            << duration.count() << " microseconds, "
+            << AISystem::pathStats.expanded << " nodes expanded, "
+            << AISystem::pathStats.heapOperations << " heap operations" << std::endl;
     }
 
     if (ECS::registry<Turn>.components[0].type == ENEMY && !AISystem::aiMoved) {
@@ -571,7 +1072,7 @@ BTState LookForSnail::process(ECS::Entity e) {
         return BTState::Failure;
     }
     //std::cout << "returning Running" << std::endl;
-    if (ECS::registry<Slug>.has(e) == true && m_inRange == true) {
+    if (ECS::registry<Slug>.has(e) == true && inRange == true) {
         int xAiPos = (aiPos.x - (0.5 * scale)) / scale;
         int yAiPos = (aiPos.y - (0.5 * scale)) / scale;
         vec2 snailLoc = ECS::registry<Motion>.get(snailEntity).position;
@@ -588,70 +1089,26 @@ BTState LookForSnail::process(ECS::Entity e) {
     return BTState::Running;
 }
 
-void LookForSnail::writeToJson(json &toSave)
-{
-    toSave[BTKeys::TYPE_KEY] = getNodeType();
-    toSave[BTKeys::IN_RANGE_KEY] = m_inRange;
-}
-
-void LookForSnail::setFromJson(const json &saved)
-{
-    m_inRange = saved[BTKeys::IN_RANGE_KEY];
-}
-
-BTState IsSnailInRange::process(ECS::Entity e) {
+static BTState isSnailInRange(ECS::Entity e) {
     //std::cout << "checking if snail is in range" << std::endl;
     int range = 7;
     // snail coordinates
-    auto& snailEntity = ECS::registry<Snail>.entities[0];
-    float scale = TileSystem::getScale();
-
-    vec2 snailPos = ECS::registry<Motion>.get(snailEntity).position;
-    int xPos = (snailPos[0] - (0.5 * scale)) / scale;
-    int yPos = (snailPos[1] - (0.5 * scale)) / scale;
-    vec2 snailCoord = { yPos, xPos };
-
-    auto entity = e;
-
-    auto tiles = TileSystem::getTiles();
-    auto& motion = ECS::registry<Motion>.get(entity);
-    vec2 aiPos = motion.position;
-    int xAiPos = (aiPos.x - (0.5 * scale)) / scale;
-    int yAiPos = (aiPos.y - (0.5 * scale)) / scale;
-    vec2 aiCoord = { yAiPos, xAiPos };
-
-    int xMax = aiCoord.x + range;
-    int xMin = aiCoord.x - range;
-    int yMax = aiCoord.y + range;
-    int yMin = aiCoord.y - range;
-
+    ECS::Entity snailEntity = ECS::registry<Snail>.entities[0];
+    ivec2 snailCoord = tileOf(ECS::registry<Motion>.get(snailEntity).position);
+    ivec2 aiCoord = tileOf(ECS::registry<Motion>.get(e).position);
 
-    if (xMax >= snailCoord.x && xMin <= snailCoord.x) {
-        //std::cout << "success1" << std::endl;
-        if (yMax >= snailCoord.y && yMin <= snailCoord.y) {
-            //std::cout << "success2" << std::endl;
-            return BTState::Success;
-        }
-        else {
-            return BTState::Failure;
-        }
+    if (Visibility::inRange(aiCoord, snailCoord, range)) {
+        return BTState::Success;
     }
     else {
-        //std::cout << "failure" << std::endl;
         return BTState::Failure;
     }
 }
 
-void IsSnailInRange::writeToJson(json &toSave)
-{
-    toSave[BTKeys::TYPE_KEY] = getNodeType();
-}
-
-
-BTState FireXShots::process(ECS::Entity e) {
+static BTState fireXShots(ECS::Entity e, int32_t& skip) {
     
-    if (m_Skip > 0) {
-        m_Skip = m_Skip - 1;
+    if (skip > 0) {
+        skip = skip - 1;
         return BTState::Failure;
     }
     //std::cout << "in FireXShots" << std::endl;
@@ -659,11 +1116,16 @@ BTState FireXShots::process(ECS::Entity e) {
     // get snail position
     vec2 slugPosition = ECS::registry<Motion>.get(e).position;
 
-    auto& snailEntity = ECS::registry<Snail>.entities[0];
+    ECS::Entity snailEntity = ECS::registry<Snail>.entities[0];
 
     // now you want to go in the direction of the (mouse_pos - snail_pos), but make it a unit vector
     vec2 snailPosition = ECS::registry<Motion>.get(snailEntity).position;
 
+    // hold the shot while there is a wall in the way
+    if (!Visibility::canSee(tileOf(slugPosition), tileOf(snailPosition))) {
+        return BTState::Success;
+    }
+
     vec2 projectilePosition = slugPosition + glm::normalize(snailPosition - slugPosition) * TileSystem::getScale() / 2.f;
     vec2 projectileVelocity = (snailPosition - projectilePosition);
     float length = glm::length(projectileVelocity);
@@ -679,85 +1141,195 @@ BTState FireXShots::process(ECS::Entity e) {
     return BTState::Success;
 }
 
-void FireXShots::writeToJson(json &toSave)
-{
-    toSave[BTKeys::TYPE_KEY] = getNodeType();
-    toSave[BTKeys::SKIP_KEY] = m_Skip;
-}
-
-void FireXShots::setFromJson(const json &saved)
-{
-    m_Skip = saved[BTKeys::SKIP_KEY];
+static BTState predictShot(ECS::Entity e) {
+    //std::cout << "in predict shot" << std::endl;
+    return BTState::Success;
 }
 
-BTState PredictShot::process(ECS::Entity e) {
-    //std::cout << "in predict shot" << std::endl;
+static BTState getToSnail(ECS::Entity e) {
     return BTState::Success;
 }
 
-void PredictShot::writeToJson(json &toSave)
+BTDefinition::BTDefinition(const Spec& root)
 {
-    toSave[BTKeys::TYPE_KEY] = getNodeType();
+    // breadth first, so the children of each node end up next to each other
+    std::vector<const Spec*> specs = { &root };
+    int slots = 0;
+    for (size_t i = 0; i < specs.size(); i++)
+    {
+        const Spec& spec = *specs[i];
+        Node node;
+        node.kind = spec.kind;
+        node.param = spec.param;
+        node.firstChild = static_cast<uint8_t>(specs.size());
+        node.childCount = static_cast<uint8_t>(spec.children.size());
+        bool hasState = spec.kind == SEQUENCE || spec.kind == SELECTOR || spec.kind == REPEAT_FOR_N
+            || spec.kind == RANDOM_SELECTOR || spec.kind == FIRE_X_SHOTS;
+        node.slot = hasState ? static_cast<int8_t>(slots++) : -1;
+        nodes.push_back(node);
+        for (const auto& child : spec.children)
+            specs.push_back(&child);
+    }
+    assert(slots <= BTInstance::MAX_SLOTS && specs.size() <= 255);
 }
 
-BTState GetToSnail::process(ECS::Entity e) {
-    return BTState::Success;
+const BTDefinition& BTDefinition::spider()
+{
+    static const BTDefinition definition({ SEQUENCE, 0, {
+        { IS_SNAIL_IN_RANGE, 0, {} },
+        { LOOK_FOR_SNAIL, 0, {} },
+    } });
+    return definition;
 }
 
-void GetToSnail::writeToJson(json &toSave)
+const BTDefinition& BTDefinition::slug()
 {
-    toSave[BTKeys::TYPE_KEY] = getNodeType();
+    static const BTDefinition definition({ SEQUENCE, 0, {
+        { IS_SNAIL_IN_RANGE, 0, {} },
+        { SELECTOR, 0, {
+            { REPEAT_FOR_N, 50, {
+                { LOOK_FOR_SNAIL, 1, {} },
+            } },
+            { FIRE_X_SHOTS, 0, {} },
+        } },
+        { LOOK_FOR_SNAIL, 0, {} },
+    } });
+    return definition;
 }
 
-std::shared_ptr<BTNode> BTNode::createSubclassNode(NodeType const& type)
+BTInstance BTDefinition::start(ECS::Entity e) const
 {
-    // T.T really hurts the eyes... sorry
-
-    std::shared_ptr<BTNode> node;
-    if (type == BTKeys::NodeTypes::SEQUENCE_KEY)
+    BTInstance instance = {};
+    // the counters count down over the whole life of the entity, they aren't reset with their node
+    for (const auto& node : nodes)
     {
-        node = std::make_shared<BTSequence>(std::vector<std::shared_ptr<BTNode>>());
+        if (node.kind == REPEAT_FOR_N || node.kind == FIRE_X_SHOTS)
+            instance.slots[node.slot] = node.param;
     }
-    else if (type == BTKeys::NodeTypes::SELECTOR_KEY)
+    init(0, e, instance);
+    return instance;
+}
+
+BTState BTDefinition::process(ECS::Entity e, BTInstance& instance) const
+{
+    return process(0, e, instance);
+}
+
+void BTDefinition::init(int index, ECS::Entity e, BTInstance& instance) const
+{
+    const Node& node = nodes[index];
+    switch (node.kind)
     {
-        node = std::make_shared<BTSelector>(std::vector<std::shared_ptr<BTNode>>());
-    }
-    else if (type == BTKeys::NodeTypes::REPEAT_FOR_N_KEY)
+    case SEQUENCE:
+    case SELECTOR:
+        // start from the first child
+        instance.slots[node.slot] = 0;
+        init(node.firstChild, e, instance);
+        break;
+    case REPEAT_FOR_N:
+        init(node.firstChild, e, instance);
+        break;
+    case RANDOM_SELECTOR:
     {
-        node = std::make_shared<RepeatForN>(nullptr, 0);
+        int chosen = 1 + rand() % 100 <= node.param ? 0 : 1;
+        instance.slots[node.slot] = chosen;
+        init(node.firstChild + chosen, e, instance);
+        break;
     }
-    else if (type == BTKeys::NodeTypes::SNAIL_IN_RANGE_KEY)
-    {
-        node = std::make_shared<IsSnailInRange>();
+    default:
+        break;
     }
-    else if (type == BTKeys::NodeTypes::LOOK_FOR_SNAIL_KEY)
+}
+
+BTState BTDefinition::process(int index, ECS::Entity e, BTInstance& instance) const
+{
+    const Node& node = nodes[index];
+    switch (node.kind)
     {
-        node = std::make_shared<LookForSnail>();
-    }
-    else if (type == BTKeys::NodeTypes::FIRE_X_SHOTS_KEY)
+    case SEQUENCE:
     {
-        node = std::make_shared<FireXShots>();
+        int32_t& child = instance.slots[node.slot];
+        if (child >= node.childCount)
+            return BTState::Success;
+        BTState state = process(node.firstChild + child, e, instance);
+        // select a new active child and initialize its internal state
+        if (state != BTState::Success)
+            return state;
+        if (++child >= node.childCount)
+            return BTState::Success;
+        init(node.firstChild + child, e, instance);
+        return BTState::Running;
     }
-    else if (type == BTKeys::NodeTypes::RANDOM_SELECTOR)
+    case SELECTOR:
     {
-        node = std::make_shared<RandomSelector>(0, nullptr, nullptr);
+        int32_t& child = instance.slots[node.slot];
+        if (child >= node.childCount)
+            return BTState::Success;
+        BTState state = process(node.firstChild + child, e, instance);
+        if (state != BTState::Failure)
+            return state;
+        // move on to the next child
+        if (++child >= node.childCount)
+            return BTState::Failure;
+        init(node.firstChild + child, e, instance);
+        return BTState::Running;
     }
-    else if (type == BTKeys::NodeTypes::PREDICT_SHOT_KEY)
+    case REPEAT_FOR_N:
     {
-        node = std::make_shared<PredictShot>();
+        int32_t& iterationsRemaining = instance.slots[node.slot];
+        BTState state = process(node.firstChild, e, instance);
+        if (iterationsRemaining > 0 && state == BTState::Running) {
+            iterationsRemaining = iterationsRemaining - 1;
+            return BTState::Running;
+        }
+        if (iterationsRemaining > 0 && state == BTState::Failure) {
+            iterationsRemaining = iterationsRemaining - 10;
+            return BTState::Running;
+        }
+        return state == BTState::Success ? BTState::Success : BTState::Failure;
     }
-    else if (type == BTKeys::NodeTypes::GET_TO_SNAIL_KEY)
+    case RANDOM_SELECTOR:
     {
-        node = std::make_shared<GetToSnail>();
+        BTState state = process(node.firstChild + instance.slots[node.slot], e, instance);
+        return state == BTState::Success ? BTState::Success : BTState::Running;
     }
-    else
-    {
-        throw std::runtime_error("Cannot create BTNode subclass because type does not exist. Type: " + type);
+    case IS_SNAIL_IN_RANGE:
+        return isSnailInRange(e);
+    case LOOK_FOR_SNAIL:
+        return lookForSnail(e, node.param != 0);
+    case FIRE_X_SHOTS:
+        return fireXShots(e, instance.slots[node.slot]);
+    case PREDICT_SHOT:
+        return predictShot(e);
+    case GET_TO_SNAIL:
+        return getToSnail(e);
     }
-    return node;
+    return BTState::Failure;
+}
+
+void BTInstance::writeToJson(json& toSave) const
+{
+    toSave = std::vector<int32_t>(std::begin(slots), std::end(slots));
+}
+
+void BTInstance::setFromJson(json const& saved)
+{
+    // saves from before the trees were shared have the whole tree instead, those start over
+    if (!saved.is_array())
+        return;
+    std::vector<int32_t> savedSlots = saved;
+    std::copy_n(savedSlots.begin(), std::min<size_t>(savedSlots.size(), MAX_SLOTS), slots);
 }
 
+AISystem::PathStats AISystem::pathStats;
+AISystem::DistanceField AISystem::snailField;
+int AISystem::speculatedTile = -1;
+unsigned int AISystem::speculatedVersion = 0;
 bool AISystem::aiMoved = false;
+float AISystem::frameBudgetMicroseconds = 2000.f;
+std::vector<ECS::Entity> AISystem::turnQueue;
+size_t AISystem::turnNext = 0;
+bool AISystem::turnStarted = false;
 bool AISystem::fire = true;
 std::string AISystem::aiPathFindingAlgorithm = "BFS";
 //std::vector<vec2> birdPath = AISystem::getBirdPath();
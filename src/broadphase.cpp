@@ -0,0 +1,161 @@
+// header
+#include "broadphase.hpp"
+#include "tiles/tiles.hpp"
+#include "hull.hpp"
+
+// stlib
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+float Broadphase::cellSize = 0.f;
+std::unordered_map<uint64_t, std::vector<ECS::Entity>> Broadphase::cells;
+std::vector<Broadphase::Pair> Broadphase::pairs;
+
+void Broadphase::reset()
+{
+	cells.clear();
+	pairs.clear();
+	ECS::registry<BroadphaseProxy>.clear();
+	cellSize = TileSystem::getScale();
+}
+
+void Broadphase::update(FilterFunction filterOf)
+{
+	if (cellSize != TileSystem::getScale())
+		reset();
+	assert(cellSize > 0.f);
+
+	auto& motions = ECS::registry<Motion>;
+	auto& proxies = ECS::registry<BroadphaseProxy>;
+	for (unsigned int i = 0; i < motions.size(); i++)
+	{
+		ECS::Entity entity = motions.entities[i];
+		bool isBinned = proxies.has(entity);
+		if (isBinned && proxies.get(entity).filter.isStatic)
+			continue; // static tiles never change cells
+
+		CollisionFilter filter = filterOf(ECS::ContainerInterface::signature_of(entity));
+		if (!isBinned && filter.layer == 0)
+			continue;
+
+		// bounding circle, same as the early out in the narrowphase, fast movers cover their whole path this step
+		const Motion& motion = motions.components[i];
+		float radius = std::sqrt(std::pow(std::abs(motion.scale.x) / 2.f, 2.f) + std::pow(std::abs(motion.scale.y) / 2.f, 2.f));
+		vec2 lo = motion.position;
+		vec2 hi = motion.position;
+		if (ECS::registry<SweptMotion>.has(entity))
+		{
+			const SweptMotion& sweep = ECS::registry<SweptMotion>.get(entity);
+			lo = min(lo, sweep.start);
+			hi = max(hi, sweep.start);
+			// a bounce back can take it past both ends
+			for (const auto& bounce : sweep.bounces)
+			{
+				lo = min(lo, bounce.position);
+				hi = max(hi, bounce.position);
+			}
+		}
+		BroadphaseProxy proxy;
+		proxy.minCell = { static_cast<int>(std::floor((lo.x - radius) / cellSize)), static_cast<int>(std::floor((lo.y - radius) / cellSize)) };
+		proxy.maxCell = { static_cast<int>(std::floor((hi.x + radius) / cellSize)), static_cast<int>(std::floor((hi.y + radius) / cellSize)) };
+		proxy.filter = filter;
+
+		if (isBinned)
+		{
+			auto& binned = proxies.get(entity);
+			binned.filter = filter; // components like NoCollide or DeathTimer can change it
+			if (binned.minCell == proxy.minCell && binned.maxCell == proxy.maxCell)
+				continue;
+			unbin(entity, binned);
+			binned = proxy;
+		}
+		else
+		{
+			proxies.emplace(entity, proxy);
+		}
+		bin(entity, proxy);
+	}
+
+	// collect the pairs from the point of view of the moving entities, static-static pairs are never generated
+	pairs.clear();
+	for (unsigned int k = 0; k < proxies.size(); k++)
+	{
+		const BroadphaseProxy& proxy = proxies.components[k];
+		if (proxy.filter.isStatic || proxy.filter.collidesWith == 0)
+			continue;
+		ECS::Entity entity = proxies.entities[k];
+		unsigned int i = motions.storage_index(entity);
+		if (i == ECS::SparseIndex::npos)
+			continue;
+
+		for (int y = proxy.minCell.y; y <= proxy.maxCell.y; y++)
+		{
+			for (int x = proxy.minCell.x; x <= proxy.maxCell.x; x++)
+			{
+				auto cell = cells.find(cellKey(x, y));
+				if (cell == cells.end())
+					continue;
+				auto& binned = cell->second;
+				for (size_t n = 0; n < binned.size();)
+				{
+					ECS::Entity other = binned[n];
+					unsigned int j = motions.storage_index(other);
+					if (j == ECS::SparseIndex::npos || !proxies.has(other))
+					{
+						// the entity was removed since it was binned, drop it from the cell
+						binned[n] = binned.back();
+						binned.pop_back();
+						continue;
+					}
+					n++;
+					// the layer table is symmetric, so one side's mask decides
+					const CollisionFilter& otherFilter = proxies.get(other).filter;
+					if ((proxy.filter.collidesWith & otherFilter.layer) == 0)
+						continue;
+					// moving pairs are found from both sides, only keep one of them
+					if (other.id == entity.id || (!otherFilter.isStatic && otherFilter.collidesWith != 0 && j < i))
+						continue;
+					pairs.emplace_back(std::min(i, j), std::max(i, j));
+				}
+			}
+		}
+	}
+
+	// entities spanning several cells are found once per shared cell
+	std::sort(pairs.begin(), pairs.end());
+	pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+}
+
+const std::vector<Broadphase::Pair>& Broadphase::candidatePairs()
+{
+	return pairs;
+}
+
+uint64_t Broadphase::cellKey(int x, int y)
+{
+	return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y);
+}
+
+void Broadphase::bin(ECS::Entity entity, const BroadphaseProxy& proxy)
+{
+	for (int y = proxy.minCell.y; y <= proxy.maxCell.y; y++)
+		for (int x = proxy.minCell.x; x <= proxy.maxCell.x; x++)
+			cells[cellKey(x, y)].push_back(entity);
+}
+
+void Broadphase::unbin(ECS::Entity entity, const BroadphaseProxy& proxy)
+{
+	for (int y = proxy.minCell.y; y <= proxy.maxCell.y; y++)
+	{
+		for (int x = proxy.minCell.x; x <= proxy.maxCell.x; x++)
+		{
+			auto cell = cells.find(cellKey(x, y));
+			if (cell == cells.end())
+				continue;
+			auto& binned = cell->second;
+			// empty cells are kept until the next reset, so bodies moving through them don't allocate them again
+			binned.erase(std::remove_if(binned.begin(), binned.end(), [&](ECS::Entity e) { return e.id == entity.id; }), binned.end());
+		}
+	}
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+// internal
+#include "common.hpp"
+#include "tiny_ecs.hpp"
+
+// stlib
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Which collision layer an entity is on and which layers it collides with, one bit per layer
+struct CollisionFilter
+{
+	uint32_t layer = 0; // 0 means the entity doesn't collide at all
+	uint32_t collidesWith = 0;
+	bool isStatic = false; // never moves, so it is only binned once
+};
+
+// The range of grid cells an entity is currently binned in and its filter, owned by the Broadphase
+struct BroadphaseProxy
+{
+	ivec2 minCell = { 0, 0 };
+	ivec2 maxCell = { 0, 0 };
+	CollisionFilter filter;
+};
+
+// Uniform grid over the world with cells the size of a tile, used to find the pairs of entities that can possibly collide
+// without testing every pair. An entity is binned in every cell its bounding circle overlaps, so any two entities whose
+// bounding circles overlap share at least one cell. Entities with a SweptMotion are binned along their path this step.
+class Broadphase
+{
+public:
+	// pair of indices into ECS::registry<Motion>, first < second
+	typedef std::pair<unsigned int, unsigned int> Pair;
+
+	// forget all binned entities, done on level load since the tiles (and their scale) change
+	static void reset();
+
+	// gives the collision filter of an entity from its components
+	typedef CollisionFilter (*FilterFunction)(const ECS::Signature& signature);
+
+	// bins the entities with a Motion that are on a collision layer, static ones are only binned once,
+	// the others are re-binned when the cells they overlap change and get their filter updated
+	static void update(FilterFunction filterOf);
+
+	// all pairs of binned entities that share a cell, collide with each other's layers and are not both static, sorted by motion index
+	static const std::vector<Pair>& candidatePairs();
+
+private:
+	static float cellSize;
+	static std::unordered_map<uint64_t, std::vector<ECS::Entity>> cells;
+	static std::vector<Pair> pairs;
+
+	static uint64_t cellKey(int x, int y);
+	static void bin(ECS::Entity entity, const BroadphaseProxy& proxy);
+	static void unbin(ECS::Entity entity, const BroadphaseProxy& proxy);
+};
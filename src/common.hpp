@@ -52,6 +52,10 @@ struct Transform {
 
 #define AI_PF_ALGO_BFS  "BFS"
 #define AI_PF_ALGO_A_STAR "Astar"
+#define AI_PF_ALGO_JPS "JPS"
+#define AI_PF_ALGO_HPA "HPA"
+// every enemy follows one shared field of distances to the snail
+#define AI_PF_ALGO_DISTANCE_FIELD "DistanceField"
 
 // for use with levels_path(): use indices, starting from 0
 const std::vector<std::string> levels = { "tutorial.json", "level-1.json", "level-2.json", "level-3.json", "level-4.json"};
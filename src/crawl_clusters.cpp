@@ -0,0 +1,256 @@
+// header
+#include "crawl_clusters.hpp"
+#include "crawl_graph.hpp"
+
+// stlib
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <limits>
+#include <queue>
+
+std::vector<CrawlClusters::Entrance> CrawlClusters::entrances;
+std::vector<int> CrawlClusters::edgeOffsets;
+std::vector<CrawlClusters::Edge> CrawlClusters::edges;
+std::vector<std::vector<int>> CrawlClusters::clusterEntrances;
+unsigned int CrawlClusters::builtVersion = 0;
+
+static const int UNREACHED = std::numeric_limits<int>::max();
+
+// corner moves pass through two tiles
+static int moveCost(const CrawlGraph::Move& move)
+{
+	return move.via >= 0 ? 2 : 1;
+}
+
+static int clustersPerRow()
+{
+	return (CrawlGraph::columns() + CrawlClusters::CLUSTER_SIZE - 1) / CrawlClusters::CLUSTER_SIZE;
+}
+
+int CrawlClusters::clusterOf(int tile)
+{
+	ivec2 coord = CrawlGraph::tile(tile);
+	return (coord.x / CLUSTER_SIZE) * clustersPerRow() + coord.y / CLUSTER_SIZE;
+}
+
+int CrawlClusters::localIndex(int tile)
+{
+	ivec2 coord = CrawlGraph::tile(tile);
+	return (coord.x % CLUSTER_SIZE) * CLUSTER_SIZE + coord.y % CLUSTER_SIZE;
+}
+
+int CrawlClusters::searchCluster(int from, std::vector<int>& cost, std::vector<int>& parent)
+{
+	int expanded = 0;
+	typedef std::pair<int, int> Reached; // (cost, tile)
+	std::priority_queue<Reached, std::vector<Reached>, std::greater<Reached>> open;
+	int cluster = clusterOf(from);
+	cost.assign(CLUSTER_SIZE * CLUSTER_SIZE, UNREACHED);
+	parent.assign(CLUSTER_SIZE * CLUSTER_SIZE, -1);
+	cost[localIndex(from)] = 0;
+	open.push({ 0, from });
+	while (!open.empty())
+	{
+		Reached current = open.top();
+		open.pop();
+		if (current.first > cost[localIndex(current.second)])
+			continue;
+		expanded++;
+		for (const auto& move : CrawlGraph::movesFrom(current.second))
+		{
+			if (clusterOf(move.to) != cluster)
+				continue;
+			int next = current.first + moveCost(move);
+			int local = localIndex(move.to);
+			if (next < cost[local])
+			{
+				cost[local] = next;
+				parent[local] = current.second;
+				open.push({ next, move.to });
+			}
+		}
+	}
+	return expanded;
+}
+
+void CrawlClusters::appendClusterPath(const std::vector<int>& parent, int to, std::vector<int>& tiles)
+{
+	size_t first = tiles.size();
+	for (int tile = to; parent[localIndex(tile)] >= 0; tile = parent[localIndex(tile)])
+		tiles.push_back(tile);
+	std::reverse(tiles.begin() + first, tiles.end());
+}
+
+void CrawlClusters::build()
+{
+	builtVersion = CrawlGraph::version();
+	int tiles = CrawlGraph::rows() * CrawlGraph::columns();
+	int clusterRows = (CrawlGraph::rows() + CLUSTER_SIZE - 1) / CLUSTER_SIZE;
+	entrances.clear();
+	clusterEntrances.assign(clusterRows * clustersPerRow(), {});
+
+	// both ends of every move between two clusters
+	std::vector<int> entranceOf(tiles, -1);
+	auto addEntrance = [&entranceOf](int tile)
+	{
+		if (entranceOf[tile] >= 0)
+			return;
+		entranceOf[tile] = static_cast<int>(entrances.size());
+		clusterEntrances[clusterOf(tile)].push_back(entranceOf[tile]);
+		entrances.push_back({ tile, {}, {} });
+	};
+	for (int tile = 0; tile < tiles; tile++)
+	{
+		for (const auto& move : CrawlGraph::movesFrom(tile))
+		{
+			if (clusterOf(move.to) != clusterOf(tile))
+			{
+				addEntrance(tile);
+				addEntrance(move.to);
+			}
+		}
+	}
+
+	// an entrance connects to the entrances of its cluster it can reach inside of it, and across the moves leaving it
+	edgeOffsets.assign(1, 0);
+	edges.clear();
+	for (auto& entrance : entrances)
+	{
+		searchCluster(entrance.tile, entrance.cost, entrance.parent);
+		for (int other : clusterEntrances[clusterOf(entrance.tile)])
+		{
+			int cost = entrance.cost[localIndex(entrances[other].tile)];
+			if (entrances[other].tile != entrance.tile && cost != UNREACHED)
+				edges.push_back({ other, cost });
+		}
+		for (const auto& move : CrawlGraph::movesFrom(entrance.tile))
+		{
+			if (clusterOf(move.to) != clusterOf(entrance.tile))
+				edges.push_back({ entranceOf[move.to], moveCost(move) });
+		}
+		edgeOffsets.push_back(static_cast<int>(edges.size()));
+	}
+}
+
+std::vector<vec2> CrawlClusters::findPath(int startTile, int goalTile, int& expanded)
+{
+	// per entrance, kept around to reuse the memory
+	static std::vector<int> cost;
+	static std::vector<int> cameFrom;
+	static std::vector<bool> closed;
+	static std::vector<int> startCost;
+	static std::vector<int> startParent;
+
+	assert(startTile >= 0);
+	expanded = 0;
+	vec2 start = vec2(CrawlGraph::tile(startTile));
+	if (goalTile < 0)
+		return { start };
+	// a tile changed since the level loaded
+	if (builtVersion != CrawlGraph::version())
+		build();
+
+	int goalCluster = clusterOf(goalTile);
+	int goalLocal = localIndex(goalTile);
+	expanded += searchCluster(startTile, startCost, startParent);
+
+	// staying inside the cluster is the best until going through the entrances is shorter
+	int best = clusterOf(startTile) == goalCluster ? startCost[goalLocal] : UNREACHED;
+	int bestEntrance = -1;
+
+	ivec2 goalCoord = CrawlGraph::tile(goalTile);
+	// every step moves one tile, so the manhattan distance never overestimates
+	auto heuristic = [&goalCoord](int entrance)
+	{
+		ivec2 coord = CrawlGraph::tile(entrances[entrance].tile);
+		return abs(coord.x - goalCoord.x) + abs(coord.y - goalCoord.y);
+	};
+
+	typedef std::pair<int, int> Estimate; // (estimate, entrance)
+	std::priority_queue<Estimate, std::vector<Estimate>, std::greater<Estimate>> open;
+	cost.assign(entrances.size(), UNREACHED);
+	cameFrom.assign(entrances.size(), -1);
+	closed.assign(entrances.size(), false);
+	for (int entrance : clusterEntrances[clusterOf(startTile)])
+	{
+		int reached = startCost[localIndex(entrances[entrance].tile)];
+		if (reached == UNREACHED)
+			continue;
+		cost[entrance] = reached;
+		open.push({ reached + heuristic(entrance), entrance });
+	}
+
+	while (!open.empty() && open.top().first < best)
+	{
+		int current = open.top().second;
+		open.pop();
+		if (closed[current])
+			continue;
+		closed[current] = true;
+		expanded++;
+
+		if (clusterOf(entrances[current].tile) == goalCluster)
+		{
+			int remaining = entrances[current].cost[goalLocal];
+			if (remaining != UNREACHED && cost[current] + remaining < best)
+			{
+				best = cost[current] + remaining;
+				bestEntrance = current;
+			}
+		}
+		for (int i = edgeOffsets[current]; i < edgeOffsets[current + 1]; i++)
+		{
+			const Edge& edge = edges[i];
+			int next = cost[current] + edge.cost;
+			if (closed[edge.to] || next >= cost[edge.to])
+				continue;
+			cost[edge.to] = next;
+			cameFrom[edge.to] = current;
+			open.push({ next + heuristic(edge.to), edge.to });
+		}
+	}
+	if (best == UNREACHED)
+		return { start };
+
+	// fill in the tiles between the entrances
+	std::vector<int> chain;
+	for (int entrance = bestEntrance; entrance >= 0; entrance = cameFrom[entrance])
+		chain.push_back(entrance);
+	std::reverse(chain.begin(), chain.end());
+	std::vector<int> tiles = { startTile };
+	if (chain.empty())
+	{
+		appendClusterPath(startParent, goalTile, tiles);
+	}
+	else
+	{
+		appendClusterPath(startParent, entrances[chain[0]].tile, tiles);
+		for (size_t i = 1; i < chain.size(); i++)
+		{
+			const Entrance& from = entrances[chain[i - 1]];
+			const Entrance& to = entrances[chain[i]];
+			if (clusterOf(from.tile) == clusterOf(to.tile))
+				appendClusterPath(from.parent, to.tile, tiles);
+			else
+				tiles.push_back(to.tile);
+		}
+		appendClusterPath(entrances[chain.back()].parent, goalTile, tiles);
+	}
+
+	// and the tiles passed around corners
+	std::vector<vec2> path = { start };
+	for (size_t i = 1; i < tiles.size(); i++)
+	{
+		const CrawlGraph::Move* taken = nullptr;
+		for (const auto& move : CrawlGraph::movesFrom(tiles[i - 1]))
+		{
+			if (move.to == tiles[i] && (!taken || moveCost(move) < moveCost(*taken)))
+				taken = &move;
+		}
+		if (taken->via >= 0)
+			path.push_back(vec2(CrawlGraph::tile(taken->via)));
+		path.push_back(vec2(CrawlGraph::tile(tiles[i])));
+	}
+	return path;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+// internal
+#include "common.hpp"
+
+// stlib
+#include <vector>
+
+// Hierarchical path finding over the crawl graph. The level is cut into square clusters, and the tiles with a move
+// into another cluster are the entrances. The distances between the entrances of a cluster are found once per level,
+// so a search only walks the tiles of the start cluster and then the much smaller graph of entrances.
+// The paths are close to the shortest but not always the shortest.
+class CrawlClusters
+{
+public:
+	// width and height of a cluster in tiles
+	static const int CLUSTER_SIZE = 10;
+
+	// cut the crawl graph into clusters, on level load once the crawl graph is built
+	static void build();
+
+	// path from the start tile to the goal tile as (row, column) tiles, corners included,
+	// just the start if the goal can't be reached
+	static std::vector<vec2> findPath(int startTile, int goalTile, int& expanded);
+
+private:
+	struct Entrance
+	{
+		int tile;
+		// shortest distance from the entrance to every tile of its cluster without leaving it,
+		// and the tile each one is reached from, indexed by localIndex
+		std::vector<int> cost;
+		std::vector<int> parent;
+	};
+
+	struct Edge
+	{
+		int to; // entrance
+		int cost;
+	};
+
+	static std::vector<Entrance> entrances;
+	// edges of entrance e are edges[edgeOffsets[e]] up to edges[edgeOffsets[e + 1]]
+	static std::vector<int> edgeOffsets;
+	static std::vector<Edge> edges;
+	// the entrances of each cluster
+	static std::vector<std::vector<int>> clusterEntrances;
+	// the crawl graph version the clusters were cut from
+	static unsigned int builtVersion;
+
+	static int clusterOf(int tile);
+	// index of a tile within its cluster
+	static int localIndex(int tile);
+	// shortest distances from a tile to the rest of its cluster without leaving it, returns the tiles expanded
+	static int searchCluster(int from, std::vector<int>& cost, std::vector<int>& parent);
+	// adds the tiles from a search of a cluster, from where the search started up to the given tile
+	static void appendClusterPath(const std::vector<int>& parent, int to, std::vector<int>& tiles);
+};
@@ -0,0 +1,158 @@
+// header
+#include "crawl_graph.hpp"
+#include "tiles/tiles.hpp"
+
+// stlib
+#include <algorithm>
+
+CrawlGraph::Data CrawlGraph::graph;
+
+// type of the tile at (row, column), INACCESSIBLE outside of the grid
+static TYPE tileType(const std::vector<std::vector<Tile>>& tiles, int row, int col)
+{
+	if (row < 0 || row >= static_cast<int>(tiles.size()) || col < 0 || col >= static_cast<int>(tiles[row].size()))
+		return INACCESSIBLE;
+	return tiles[row][col].type;
+}
+
+void CrawlGraph::build()
+{
+	graph.version++;
+	ivec2 size = TileSystem::getTileMovesGridSize();
+	graph.rowCount = size.x;
+	graph.columnCount = size.y;
+	graph.offsets.assign(1, 0);
+	graph.offsets.reserve(graph.rowCount * graph.columnCount + 1);
+	graph.moves.clear();
+	std::vector<Move> derived;
+	for (int row = 0; row < graph.rowCount; row++)
+	{
+		for (int col = 0; col < graph.columnCount; col++)
+		{
+			deriveMoves(row, col, derived);
+			graph.moves.insert(graph.moves.end(), derived.begin(), derived.end());
+			graph.offsets.push_back(static_cast<int>(graph.moves.size()));
+		}
+	}
+}
+
+void CrawlGraph::tileChanged(int row, int col)
+{
+	graph.version++;
+	std::vector<Move> derived;
+	auto& offsets = graph.offsets;
+	auto& moves = graph.moves;
+	// the rules of a tile only look at the tiles next to it
+	for (int r = row - 1; r <= row + 1; r++)
+	{
+		for (int c = col - 1; c <= col + 1; c++)
+		{
+			int t = index(r, c);
+			if (t < 0)
+				continue;
+			deriveMoves(r, c, derived);
+			auto first = moves.begin() + offsets[t];
+			auto last = moves.begin() + offsets[t + 1];
+			int grown = static_cast<int>(derived.size()) - offsets[t + 1] + offsets[t];
+			if (grown == 0)
+			{
+				std::copy(derived.begin(), derived.end(), first);
+				continue;
+			}
+			first = moves.erase(first, last);
+			moves.insert(first, derived.begin(), derived.end());
+			for (size_t i = t + 1; i < offsets.size(); i++)
+				offsets[i] += grown;
+		}
+	}
+}
+
+int CrawlGraph::Data::index(int row, int col) const
+{
+	if (row < 0 || row >= rowCount || col < 0 || col >= columnCount)
+		return -1;
+	return row * columnCount + col;
+}
+
+ivec2 CrawlGraph::Data::tile(int index) const { return { index / columnCount, index % columnCount }; }
+
+CrawlGraph::MoveRange CrawlGraph::Data::movesFrom(int index) const
+{
+	const Move* data = moves.data();
+	return { data + offsets[index], data + offsets[index + 1] };
+}
+
+const CrawlGraph::Data& CrawlGraph::data() { return graph; }
+unsigned int CrawlGraph::version() { return graph.version; }
+int CrawlGraph::rows() { return graph.rowCount; }
+int CrawlGraph::columns() { return graph.columnCount; }
+int CrawlGraph::index(int row, int col) { return graph.index(row, col); }
+ivec2 CrawlGraph::tile(int index) { return graph.tile(index); }
+CrawlGraph::MoveRange CrawlGraph::movesFrom(int index) { return graph.movesFrom(index); }
+
+void CrawlGraph::deriveMoves(int r, int c, std::vector<Move>& out)
+{
+	auto& tiles = TileSystem::getTiles();
+	auto type = [&tiles](int row, int col) { return tileType(tiles, row, col); };
+	out.clear();
+	// a move onto a tile the moves map allows
+	auto add = [&out](bool allowed, ivec2 to, ivec2 via, ivec2 visits, MoveKind kind)
+	{
+		if (allowed && TileSystem::isMoveTile(to.x, to.y))
+			out.push_back({ index(to.x, to.y), kind == CORNER_MOVE ? index(via.x, via.y) : -1, index(visits.x, visits.y), kind });
+	};
+	auto step = [&add](bool allowed, ivec2 to) { add(allowed, to, to, to, WALL_MOVE); };
+	auto corner = [&add](bool allowed, ivec2 via, ivec2 to) { add(allowed, to, via, to, CORNER_MOVE); };
+	auto vine = [&add](bool allowed, ivec2 to) { add(allowed, to, to, to, VINE_MOVE); };
+
+	// wall above
+	if (type(r-1, c) == WALL) {
+		corner(type(r, c-1) == EMPTY, {r, c-1}, {r-1, c-1});
+		corner(type(r, c+1) == EMPTY, {r, c+1}, {r-1, c+1});
+		// left tile
+		step(type(r-1, c-1) == WALL, {r, c-1});
+		// right tile
+		step(type(r-1, c+1) == WALL, {r, c+1});
+	}
+	// wall on the right
+	if (type(r, c+1) == WALL) {
+		corner(type(r+1, c) == EMPTY, {r+1, c}, {r+1, c+1});
+		corner(type(r-1, c) == EMPTY, {r-1, c}, {r-1, c+1});
+		// up tile
+		step(type(r-1, c+1) == WALL, {r-1, c});
+		// down tile
+		step(type(r+1, c+1) == WALL, {r+1, c});
+	}
+	// wall on the left
+	if (type(r, c-1) == WALL) {
+		corner(type(r-1, c) == EMPTY, {r-1, c}, {r-1, c-1});
+		corner(type(r+1, c) == EMPTY, {r+1, c}, {r+1, c-1});
+		// up tile
+		step(type(r-1, c-1) == WALL, {r-1, c});
+		// down tile
+		step(type(r+1, c-1) == WALL, {r+1, c});
+	}
+	// wall below
+	if (type(r+1, c) == WALL) {
+		// going around this corner marks the tile on the other side as visited, the BFS paths depend on it
+		add(type(r, c+1) == EMPTY, {r+1, c+1}, {r, c+1}, {r+1, c-1}, CORNER_MOVE);
+		corner(type(r, c-1) == EMPTY, {r, c-1}, {r+1, c-1});
+		// left tile
+		step(type(r+1, c-1) == WALL, {r, c-1});
+		// right tile
+		step(type(r+1, c+1) == WALL, {r, c+1});
+	}
+
+	// onto a vine
+	vine(type(r, c-1) == VINE, {r, c-1});
+	vine(type(r, c+1) == VINE, {r, c+1});
+	vine(type(r-1, c) == VINE, {r-1, c});
+	vine(type(r+1, c) == VINE, {r+1, c});
+
+	// off the current vine, along a wall
+	bool onVine = type(r, c) == VINE;
+	vine(onVine && (type(r+1, c-1) == WALL || type(r-1, c-1) == WALL), {r, c-1});
+	vine(onVine && (type(r-1, c+1) == WALL || type(r+1, c+1) == WALL), {r, c+1});
+	vine(onVine && (type(r-1, c-1) == WALL || type(r-1, c+1) == WALL), {r-1, c});
+	vine(onVine && (type(r+1, c-1) == WALL || type(r+1, c+1) == WALL), {r+1, c});
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+// internal
+#include "common.hpp"
+
+// stlib
+#include <cstdint>
+#include <vector>
+
+// The moves a crawling enemy can make between tiles, derived from the tile types and the moves map once per level
+// instead of on every path finding step. Stored as compressed rows: the moves from a tile are contiguous, in the order
+// the path finding tries them. Tiles are indexed row * columns + column, like the moves grid.
+class CrawlGraph
+{
+public:
+	enum MoveKind : uint8_t
+	{
+		WALL_MOVE, // to the next tile along a wall
+		CORNER_MOVE, // around the corner of a wall, through the via tile
+		VINE_MOVE, // onto or along a vine
+	};
+
+	struct Move
+	{
+		int to;
+		int via; // the tile passed on the way around a corner, -1 for the other kinds
+		int visits; // marked as visited by the BFS after taking the move, the destination except for one corner
+		MoveKind kind;
+	};
+
+	struct MoveRange
+	{
+		const Move* first;
+		const Move* last;
+		const Move* begin() const { return first; }
+		const Move* end() const { return last; }
+	};
+
+	// The graph itself. It can be copied for a search off the main thread.
+	struct Data
+	{
+		// changes whenever the moves do, for anything derived from them
+		unsigned int version = 0;
+		int rowCount = 0;
+		int columnCount = 0;
+		// moves of tile t are moves[offsets[t]] up to moves[offsets[t + 1]]
+		std::vector<int> offsets = { 0 };
+		std::vector<Move> moves;
+
+		// -1 outside of the grid
+		int index(int row, int col) const;
+		// (row, column) of a tile index
+		ivec2 tile(int index) const;
+		MoveRange movesFrom(int index) const;
+	};
+
+	// the current graph, for the main thread
+	static const Data& data();
+
+	// derive the moves of every tile, on level load once the moves map is built
+	static void build();
+	// a tile changed type, re-derive the moves of the tiles whose rules look at it
+	static void tileChanged(int row, int col);
+
+	static int rows();
+	static int columns();
+	// -1 outside of the grid
+	static int index(int row, int col);
+	// (row, column) of a tile index
+	static ivec2 tile(int index);
+
+	static MoveRange movesFrom(int index);
+
+	// changes whenever the moves do, for anything derived from them
+	static unsigned int version();
+
+private:
+	static Data graph;
+
+	static void deriveMoves(int row, int col, std::vector<Move>& out);
+};
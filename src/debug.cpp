@@ -64,9 +64,8 @@ namespace DebugSystem
 
 	void clearDebugComponents() {
 		// Clear old debugging visualizations
-		while (ECS::registry<DebugComponent>.entities.size() > 0) {
-			ECS::ContainerInterface::remove_all_components_of(ECS::registry<DebugComponent>.entities.back());
-		}
+		auto& debugEntities = ECS::registry<DebugComponent>.entities;
+		ECS::ContainerInterface::remove_all_components_of(std::vector<ECS::Entity>(debugEntities.begin(), debugEntities.end()));
 	}
 
 	bool in_debug_mode = false;
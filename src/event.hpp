@@ -3,20 +3,37 @@
 #include "common.hpp"
 #include "tiny_ecs.hpp"
 
+// stlib
+#include <vector>
+
+// A pair of entities physics found touching during a step
+struct CollisionContact
+{
+	ECS::Entity entity = ECS::Entity::null();
+	ECS::Entity other = ECS::Entity::null();
+	// direction to move entity out of other, and how far. Nothing resolves body overlaps with it yet, the projectiles
+	// bounce off walls with the face normal of the tile traversal instead (see moveProjectile)
+	vec2 normal = { 0, 0 };
+	float depth = 0.f;
+	// fraction of the step at which they first touched
+	float toi = 1.f;
+};
+
 class Event
 {
 public:
-	enum EventType { COLLISION, PROJECTILE_POPPED, LOAD_LEVEL, LOAD_SAVE, LOAD_BG, CLOSE_BG, MENU_START, MENU_OPEN, MENU_CLOSE, MENU_CLOSE_ALL, PAUSE, UNPAUSE, TILE_OCCUPIED, TILE_UNOCCUPIED, LEVEL_LOADED, START_DIALOGUE, NEXT_DIALOGUE, RESUME_DIALOGUE, END_DIALOGUE, LEVEL_COMPLETE, NEXT_LEVEL, GAME_OVER, SPLASH };
+	enum EventType { CONTACTS, PROJECTILE_POPPED, LOAD_LEVEL, LOAD_SAVE, LOAD_BG, CLOSE_BG, MENU_START, MENU_OPEN, MENU_CLOSE, MENU_CLOSE_ALL, PAUSE, UNPAUSE, TILE_OCCUPIED, TILE_UNOCCUPIED, LEVEL_LOADED, START_DIALOGUE, NEXT_DIALOGUE, RESUME_DIALOGUE, END_DIALOGUE, LEVEL_COMPLETE, NEXT_LEVEL, GAME_OVER, SPLASH };
 	// used to determine what menu type is being opened or closed
 	enum MenuType { INVALID_MENU, START_MENU, LEVEL_SELECT, PAUSE_MENU, COLLECTIBLES_MENU, LEVEL_COMPLETE_MENU, END_SCREEN};
 
 	EventType type;
-	ECS::Entity entity;
-	ECS::Entity other_entity;
+	ECS::Entity entity = ECS::Entity::null();
 	int number = -1;
 	MenuType menu = INVALID_MENU;
 	std::string dialogue;
 	int offset;
+	// the contacts of a physics step, ordered by time of impact, each pair once
+	const std::vector<CollisionContact>* contacts = nullptr;
 
 	// Stats
 	int attempts = -1;
@@ -31,8 +48,8 @@ public:
 	Event(EventType t, MenuType m) : type(t), menu(m) {}
     //splash
     Event(EventType t, ECS::Entity& e) : type(t), entity(e) {}
-	// collision
-	Event(EventType t, ECS::Entity& e, ECS::Entity& o) : type(t), entity(e), other_entity(o) {}
+	// collision contacts
+	Event(EventType t, const std::vector<CollisionContact>& c) : type(t), contacts(&c) {}
 	// start dialogue
     Event(EventType t, std::string d) : type(t), dialogue(d) {}
 	Event(EventType t, std::string d, int o) : type(t), dialogue(d), offset(o) {}
@@ -134,11 +134,14 @@ vec2 Geometry::intersectionOfLines(Geometry::Line line, Geometry::Line otherLine
 }
 
 //given a point, return true if it is inside the convex hull
-bool Geometry::pointInsideConvexHull(vec2 point, std::vector<Geometry::Line> lines)
+bool Geometry::pointInsideConvexHull(vec2 point, const std::vector<Geometry::Line>& lines)
 {
-	std::vector<bool> sides = std::vector<bool>();
-	for (auto line : lines)
+	//the point is inside if it is on the same side of every line
+	bool firstSide = false;
+	for (size_t i = 0; i < lines.size(); i++)
 	{
+		const auto& line = lines[i];
+		bool side;
 		float A = line.y1 - line.y0; //dy
 		float B = line.x0 - line.x1; //-dx
 		if (B == 0)
@@ -147,13 +150,13 @@ bool Geometry::pointInsideConvexHull(vec2 point, std::vector<Geometry::Line> lin
 			{
 				//bottom to top
 				bool pointIsOnRHSOfVerticalLine = point.x >= line.x0;
-				sides.push_back(pointIsOnRHSOfVerticalLine);
+				side = pointIsOnRHSOfVerticalLine;
 			}
 			else
 			{
 				//top to bottom
 				bool pointIsOnRHSOfVerticalLine = point.x < line.x0;
-				sides.push_back(pointIsOnRHSOfVerticalLine);
+				side = pointIsOnRHSOfVerticalLine;
 			}
 		}
 		else
@@ -164,16 +167,15 @@ bool Geometry::pointInsideConvexHull(vec2 point, std::vector<Geometry::Line> lin
 			//should be the same for either point, accounting for rounding error
 			float valueAtPoint = A * point.x + B * point.y + C;
 			bool pointIsOnRHSOfLine = valueAtPoint >= 0;
-			sides.push_back(pointIsOnRHSOfLine);
+			side = pointIsOnRHSOfLine;
 		}
-	}
 
-	//check if all the sides are the same
-	if (std::all_of(sides.begin(), sides.end(), [sides](bool val) {return val == sides[0]; }))
-	{
-		return true;
+		if (i == 0)
+			firstSide = side;
+		else if (side != firstSide)
+			return false;
 	}
-	return false;
+	return true;
 }
 
 //accounts for rounding error, is meant to double check your intersection code was correct.
@@ -27,6 +27,6 @@ public:
 	static bool linesIntersect(Line line, Line otherLine);
 	static float getIntersectingPointOnTwoParallelSegments(float x0, float otherx0);
 	static vec2 intersectionOfLines(Line line, Line otherLine);
-	static bool pointInsideConvexHull(vec2 point, std::vector<Line> lines);
+	static bool pointInsideConvexHull(vec2 point, const std::vector<Line>& lines);
 	static bool pointIsOnLine(vec2 point, Line line);
 };
\ No newline at end of file
@@ -0,0 +1,256 @@
+// header
+#include "hull.hpp"
+
+// stlib
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+bool CollisionHull::update(const Mesh& mesh, const Motion& motion)
+{
+	if (this->mesh == &mesh && position == motion.position && angle == motion.angle && scale == motion.scale)
+		return false;
+	this->mesh = &mesh;
+	position = motion.position;
+	angle = motion.angle;
+	scale = motion.scale;
+
+	center = position;
+	// fabs is to avoid negative scale due to the facing direction.
+	radius = std::sqrt(std::pow(std::abs(scale.x) / 2.0f, 2.f) + std::pow(std::abs(scale.y) / 2.0f, 2.f));
+
+	Transform transform;
+	transform.translate(position);
+	transform.rotate(angle);
+	transform.scale(scale);
+
+	// resizing keeps the capacity, so this only allocates the first time
+	const auto& indices = mesh.vertex_indices;
+	assert(!indices.empty());
+	xs.resize(indices.size());
+	ys.resize(indices.size());
+	for (size_t i = 0; i < indices.size(); i++)
+	{
+		const auto& local = mesh.vertices[indices[i]].position;
+		vec3 world = transform.mat * vec3(local.x, local.y, 1.0);
+		xs[i] = world.x;
+		ys[i] = world.y;
+	}
+	aabbMin = { *std::min_element(xs.begin(), xs.end()), *std::min_element(ys.begin(), ys.end()) };
+	aabbMax = { *std::max_element(xs.begin(), xs.end()), *std::max_element(ys.begin(), ys.end()) };
+
+	pieces.clear();
+	normalXs.clear();
+	normalYs.clear();
+	// meshes that weren't loaded face by face are a single outline
+	size_t faces = mesh.face_offsets.empty() ? 1 : mesh.face_offsets.size();
+	for (size_t face = 0; face < faces; face++)
+	{
+		Piece piece;
+		piece.begin = mesh.face_offsets.empty() ? 0 : mesh.face_offsets[face];
+		piece.end = face + 1 < faces ? mesh.face_offsets[face + 1] : indices.size();
+		if (piece.begin == piece.end)
+			continue;
+		piece.aabbMin = { *std::min_element(xs.begin() + piece.begin, xs.begin() + piece.end),
+			*std::min_element(ys.begin() + piece.begin, ys.begin() + piece.end) };
+		piece.aabbMax = { *std::max_element(xs.begin() + piece.begin, xs.begin() + piece.end),
+			*std::max_element(ys.begin() + piece.begin, ys.begin() + piece.end) };
+
+		// a negative scale mirrors the outline, flip the normals so they keep pointing outwards
+		float orientation = 0.f;
+		for (size_t i = piece.begin; i < piece.end; i++)
+		{
+			size_t next = i + 1 < piece.end ? i + 1 : piece.begin;
+			orientation += xs[i] * ys[next] - xs[next] * ys[i];
+		}
+		float outwards = orientation >= 0.f ? 1.f : -1.f;
+
+		piece.normalBegin = normalXs.size();
+		for (size_t i = piece.begin; i < piece.end; i++)
+		{
+			size_t next = i + 1 < piece.end ? i + 1 : piece.begin;
+			float dx = xs[next] - xs[i];
+			float dy = ys[next] - ys[i];
+			float length = std::sqrt(dx * dx + dy * dy);
+			if (length == 0.f)
+				continue;
+			normalXs.push_back(outwards * dy / length);
+			normalYs.push_back(-outwards * dx / length);
+		}
+		piece.normalEnd = normalXs.size();
+		pieces.push_back(piece);
+	}
+	return true;
+}
+
+void CollisionHull::project(const Piece& piece, float axisX, float axisY, float& lo, float& hi) const
+{
+	const float* x = xs.data();
+	const float* y = ys.data();
+	lo = x[piece.begin] * axisX + y[piece.begin] * axisY;
+	hi = lo;
+	for (size_t i = piece.begin + 1; i < piece.end; i++)
+	{
+		float d = x[i] * axisX + y[i] * axisY;
+		lo = d < lo ? d : lo;
+		hi = d > hi ? d : hi;
+	}
+}
+
+static bool aabbsOverlap(vec2 aMin, vec2 aMax, vec2 bMin, vec2 bMax)
+{
+	return !(any(lessThan(aMax, bMin)) || any(lessThan(bMax, aMin)));
+}
+
+bool CollisionHull::overlap(const CollisionHull& a, const CollisionHull& b, Contact& contact)
+{
+	bool overlapping = false;
+	for (const Piece& pa : a.pieces)
+	{
+		for (const Piece& pb : b.pieces)
+		{
+			if (!aabbsOverlap(pa.aabbMin, pa.aabbMax, pb.aabbMin, pb.aabbMax))
+				continue;
+			Contact pairContact;
+			if (!overlap(a, pa, b, pb, pairContact, { 0, 0 }))
+				continue;
+			// the deepest pair needs the largest push to separate the hulls
+			if (!overlapping || pairContact.depth > contact.depth)
+				contact = pairContact;
+			overlapping = true;
+		}
+	}
+	return overlapping;
+}
+
+bool CollisionHull::overlap(const CollisionHull& a, const Piece& pa, const CollisionHull& b, const Piece& pb, Contact& contact,
+	vec2 offset)
+{
+	float minDepth = std::numeric_limits<float>::max();
+	vec2 minAxis = { 0, 0 };
+
+	// the edge normals of both pieces are the only candidate separating axes for convex polygons
+	const CollisionHull* hulls[] = { &a, &b };
+	const Piece* pieces[] = { &pa, &pb };
+	for (int h = 0; h < 2; h++)
+	{
+		for (size_t i = pieces[h]->normalBegin; i < pieces[h]->normalEnd; i++)
+		{
+			float axisX = hulls[h]->normalXs[i];
+			float axisY = hulls[h]->normalYs[i];
+			float aLo, aHi, bLo, bHi;
+			a.project(pa, axisX, axisY, aLo, aHi);
+			b.project(pb, axisX, axisY, bLo, bHi);
+			float shift = offset.x * axisX + offset.y * axisY;
+			aLo += shift;
+			aHi += shift;
+			// distance a has to move along the axis (forwards or backwards) to end up past b
+			float forwards = bHi - aLo;
+			float backwards = aHi - bLo;
+			if (forwards < 0.f || backwards < 0.f)
+				return false; // found a separating axis
+			float depth = std::min(forwards, backwards);
+			if (depth < minDepth)
+			{
+				minDepth = depth;
+				minAxis = forwards < backwards ? vec2(axisX, axisY) : vec2(-axisX, -axisY);
+			}
+		}
+	}
+
+	contact.normal = minAxis;
+	contact.depth = minDepth;
+	return true;
+}
+
+bool CollisionHull::sweep(const CollisionHull& a, vec2 displacement, const CollisionHull& b, float& toi, Contact& contact,
+	vec2 offset)
+{
+	bool hit = false;
+	for (const Piece& pa : a.pieces)
+	{
+		// everywhere the piece was during the sweep
+		vec2 sweptMin = min(pa.aabbMin, pa.aabbMin - displacement) + offset;
+		vec2 sweptMax = max(pa.aabbMax, pa.aabbMax - displacement) + offset;
+		for (const Piece& pb : b.pieces)
+		{
+			if (!aabbsOverlap(sweptMin, sweptMax, pb.aabbMin, pb.aabbMax))
+				continue;
+			float pairToi;
+			Contact pairContact;
+			if (!sweep(a, pa, displacement, b, pb, pairToi, pairContact, offset))
+				continue;
+			// the first pair to touch stops the mover, the deepest one if they touched at the same time
+			if (!hit || pairToi < toi || (pairToi == toi && pairContact.depth > contact.depth))
+			{
+				toi = pairToi;
+				contact = pairContact;
+			}
+			hit = true;
+		}
+	}
+	return hit;
+}
+
+bool CollisionHull::sweep(const CollisionHull& a, const Piece& pa, vec2 displacement, const CollisionHull& b, const Piece& pb,
+	float& toi, Contact& contact, vec2 offset)
+{
+	// the interval of the step during which the projections overlap on every axis
+	float enter = 0.f;
+	float exit = 1.f;
+	// the axis that separated them last, the one they touch along
+	vec2 enterNormal = { 0, 0 };
+
+	// both hulls only translate, so the same axes as the static test separate them
+	const CollisionHull* hulls[] = { &a, &b };
+	const Piece* pieces[] = { &pa, &pb };
+	for (int h = 0; h < 2; h++)
+	{
+		for (size_t i = pieces[h]->normalBegin; i < pieces[h]->normalEnd; i++)
+		{
+			float axisX = hulls[h]->normalXs[i];
+			float axisY = hulls[h]->normalYs[i];
+			float aLo, aHi, bLo, bHi;
+			a.project(pa, axisX, axisY, aLo, aHi);
+			b.project(pb, axisX, axisY, bLo, bHi);
+			// a's projection at the start of the sweep, it moves by speed over the sweep
+			float speed = displacement.x * axisX + displacement.y * axisY;
+			float shift = offset.x * axisX + offset.y * axisY;
+			aLo += shift - speed;
+			aHi += shift - speed;
+			if (speed == 0.f)
+			{
+				if (aLo > bHi || aHi < bLo)
+					return false; // separated for the whole sweep
+				continue;
+			}
+			float t1 = (bHi - aLo) / speed;
+			float t2 = (bLo - aHi) / speed;
+			if (std::min(t1, t2) > enter)
+			{
+				enter = std::min(t1, t2);
+				// against the relative motion, away from b
+				enterNormal = speed > 0.f ? vec2(-axisX, -axisY) : vec2(axisX, axisY);
+			}
+			exit = std::min(exit, std::max(t1, t2));
+			if (enter > exit)
+				return false;
+		}
+	}
+
+	toi = enter;
+	if (enter > 0.f)
+	{
+		// just touching at the time of impact
+		contact.normal = enterNormal;
+		contact.depth = 0.f;
+	}
+	else if (!overlap(a, pa, b, pb, contact, offset))
+	{
+		// overlapped at the start but no longer, push back along the way it came
+		contact.normal = -displacement / glm::length(displacement);
+		contact.depth = 0.f;
+	}
+	return true;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+// internal
+#include "common.hpp"
+#include "render_components.hpp"
+
+// stlib
+#include <vector>
+
+// Where a fast mover was at the start of the physics step and where it bounced off walls since, so collisions can be
+// checked along its whole path. It moved in a straight line from each of these points to the next one.
+struct SweptMotion
+{
+	vec2 start = { 0, 0 };
+
+	struct Bounce
+	{
+		vec2 position = { 0, 0 };
+		// fraction of the step
+		float time = 0.f;
+	};
+	std::vector<Bounce> bounces;
+};
+
+// World-space collision hull of an entity, i.e. its reduced collision mesh (MinShadedMeshRef) transformed by its Motion.
+// Cached per entity and only recomputed when the motion or the mesh changes, so static tiles compute theirs once.
+// The reduced meshes are made of faces (a single outline for most, triangle lists for the bird, fish, slug and slug
+// projectile), each face is a convex piece and the overlap tests run piece against piece.
+// The outlines are stored as separate x and y arrays so the projections in the overlap test are plain loops over floats.
+struct CollisionHull
+{
+	// outline vertices of all pieces in world space, following the mesh vertex indices
+	std::vector<float> xs;
+	std::vector<float> ys;
+	// unit outward normal of the edge from each outline vertex to the next one of its piece (degenerate edges are skipped)
+	std::vector<float> normalXs;
+	std::vector<float> normalYs;
+
+	// one face of the mesh
+	struct Piece
+	{
+		// its vertices in xs/ys and its normals in normalXs/normalYs
+		size_t begin = 0;
+		size_t end = 0;
+		size_t normalBegin = 0;
+		size_t normalEnd = 0;
+		vec2 aabbMin = { 0, 0 };
+		vec2 aabbMax = { 0, 0 };
+	};
+	std::vector<Piece> pieces;
+
+	vec2 aabbMin = { 0, 0 };
+	vec2 aabbMax = { 0, 0 };
+	vec2 center = { 0, 0 };
+	// bounding circle around the center, from the motion scale
+	float radius = 0.f;
+
+	// Result of an overlap test
+	struct Contact
+	{
+		// direction to move the first hull out of the second one (pointing away from the second one)
+		vec2 normal = { 0, 0 };
+		// how far to move it along the normal to separate them
+		float depth = 0.f;
+	};
+
+	// recompute the hull if the mesh or motion differ from the last computation, returns whether it was recomputed
+	bool update(const Mesh& mesh, const Motion& motion);
+
+	// separating axis test of every pair of pieces (touching counts as overlapping), fills in the deepest minimum
+	// translation of the overlapping pairs if there are any
+	static bool overlap(const CollisionHull& a, const CollisionHull& b, Contact& contact);
+
+	// swept separating axis test: hull a moved by displacement during the sweep and ended it offset away from where the
+	// hull is, b stood still. Gives the fraction of the sweep at which a pair of pieces first touched (time of impact), if
+	// any did, and the axis they touched along.
+	static bool sweep(const CollisionHull& a, vec2 displacement, const CollisionHull& b, float& toi, Contact& contact,
+		vec2 offset = { 0, 0 });
+
+private:
+	// what the hull was last computed from
+	const Mesh* mesh = nullptr;
+	vec2 position = { 0, 0 };
+	float angle = 0.f;
+	vec2 scale = { 0, 0 };
+
+	// smallest and largest projection of the outline of the piece onto the axis
+	void project(const Piece& piece, float axisX, float axisY, float& lo, float& hi) const;
+
+	// the tests above for a single pair of convex pieces, with a moved by offset
+	static bool overlap(const CollisionHull& a, const Piece& pa, const CollisionHull& b, const Piece& pb, Contact& contact,
+		vec2 offset);
+	static bool sweep(const CollisionHull& a, const Piece& pa, vec2 displacement, const CollisionHull& b, const Piece& pb,
+		float& toi, Contact& contact, vec2 offset);
+};
@@ -15,6 +15,10 @@
 #include "parallax_background.hpp"
 #include "load_save.hpp"
 #include "projectile.hpp"
+#include "broadphase.hpp"
+#include "crawl_graph.hpp"
+#include "crawl_clusters.hpp"
+#include "visibility.hpp"
 
 // stlib
 #include <fstream>
@@ -71,6 +75,7 @@ void LevelLoader::loadLevel(int levelIndex, bool preview, vec2 offset, bool from
 
 	// clear tiles (if previously already loaded a level)
 	TileSystem::resetGrid();
+	Broadphase::reset();
 
     // load camera moves per turn
     unsigned turnsPerCameraMove = level["turnsPerCamera"];
@@ -249,9 +254,8 @@ void LevelLoader::loadLevel(int levelIndex, bool preview, vec2 offset, bool from
 				if (fromSave)
                 {
                     Motion motion = LoadSaveSystem::makeMotionFromJson(spider);
-                    std::shared_ptr<BTNode> tree = BTNode::createSubclassNode(spider[LoadSaveSystem::BTREE_KEY][BTKeys::TYPE_KEY]);
-                    tree->setFromJson(spider[LoadSaveSystem::BTREE_KEY]);
-                    Spider::createSpider(motion, ECS::Entity(), tree);
+                    ECS::Entity entity = Spider::createSpider(motion);
+                    ECS::registry<AI>.get(entity).instance.setFromJson(spider[LoadSaveSystem::BTREE_KEY]);
                 }
 				else
                 {
@@ -270,9 +274,8 @@ void LevelLoader::loadLevel(int levelIndex, bool preview, vec2 offset, bool from
 				if (fromSave)
                 {
                     Motion motion = LoadSaveSystem::makeMotionFromJson(slug);
-                    std::shared_ptr<BTNode> tree = BTNode::createSubclassNode(slug[LoadSaveSystem::BTREE_KEY][BTKeys::TYPE_KEY]);
-                    tree->setFromJson(slug[LoadSaveSystem::BTREE_KEY]);
-                    Slug::createSlug(motion, ECS::Entity(), tree);
+                    ECS::Entity entity = Slug::createSlug(motion);
+                    ECS::registry<AI>.get(entity).instance.setFromJson(slug[LoadSaveSystem::BTREE_KEY]);
                 }
 				else
                 {
@@ -330,9 +333,8 @@ void LevelLoader::loadLevel(int levelIndex, bool preview, vec2 offset, bool from
                 if (fromSave)
                 {
                     Motion motion = LoadSaveSystem::makeMotionFromJson(super_s);
-                    std::shared_ptr<BTNode> tree = BTNode::createSubclassNode(super_s[LoadSaveSystem::BTREE_KEY][BTKeys::TYPE_KEY]);
-                    tree->setFromJson(super_s[LoadSaveSystem::BTREE_KEY]);
-                    SuperSpider::createSuperSpider(motion, ECS::Entity(), tree);
+                    ECS::Entity entity = SuperSpider::createSuperSpider(motion);
+                    ECS::registry<AI>.get(entity).instance.setFromJson(super_s[LoadSaveSystem::BTREE_KEY]);
                 }
                 else
                 {
@@ -382,40 +384,12 @@ void LevelLoader::loadLevel(int levelIndex, bool preview, vec2 offset, bool from
         Collectible::createCollectible({ tile.x, tile.y }, id);
     }
 
-	TileSystem::vec2Map& tileMovesMap = TileSystem::getAllTileMovesMap();
-    tileMovesMap.clear();
-	int y = 0;
-	for (auto& rows : tiles) // Iterating over rows
-	{
-		int x = 0;
-		for (auto& elem : rows)
-		{
-			if (elem.type == WALL) {
-				if (y - 1 > 0 && (tiles[y - 1][x].type == VINE || tiles[y - 1][x].type == EMPTY)) {
-					auto& elem2 = tiles[y - 1][x];
-					tileMovesMap.insert({ {y - 1, x}, elem2 });
-				}
-				if (x - 1 > 0 && (tiles[y][x - 1].type == VINE || tiles[y][x - 1].type == EMPTY)) {
-					auto& elem2 = tiles[y][x - 1];
-					tileMovesMap.insert({ {y, x - 1}, elem2 });
-				}
-				if (y + 1 < tiles.size() && (tiles[y + 1][x].type == VINE || tiles[y + 1][x].type == EMPTY)) {
-					auto& elem2 = tiles[y + 1][x];
-					tileMovesMap.insert({ {y + 1, x}, elem2 });
-				}
-				if (x + 1 < tiles[y].size() && (tiles[y][x + 1].type == VINE || tiles[y][x + 1].type == EMPTY))
-				{
-					auto& elem2 = tiles[y][x + 1];
-					tileMovesMap.insert({ {y, x + 1}, elem2 });
-				}
-			}
-			else if (elem.type == VINE) {
-				tileMovesMap.insert({ {y, x}, elem });
-			}
-			x++;
-		}
-		y++;
-	}
+	TileSystem::rebuildTileMovesMap();
+	TileSystem::rebuildTileMovesGrid();
+	CrawlGraph::build();
+	Visibility::build();
+	if (AISystem::aiPathFindingAlgorithm == AI_PF_ALGO_HPA)
+		CrawlClusters::build();
 }
 
 void LevelLoader::previewLevel(int levelIndex, vec2 offset)
@@ -195,10 +195,7 @@ void LoadSaveSystem::writeLevelFile(json& toSave)
             auto& motion = ECS::registry<Motion>.get(spider);
             json character = makeMotionJson(motion);
 
-            std::shared_ptr<BTNode> tree = ECS::registry<AI>.get(spider).tree;
-            json treeJson;
-            tree->writeToJson(treeJson);
-            character[BTREE_KEY] = treeJson;
+            ECS::registry<AI>.get(spider).instance.writeToJson(character[BTREE_KEY]);
 
             toSave[CHARACTER_KEY][SPIDER_KEY].push_back(character);
         }
@@ -209,10 +206,7 @@ void LoadSaveSystem::writeLevelFile(json& toSave)
         auto& motion = ECS::registry<Motion>.get(slug);
         json character = makeMotionJson(motion);
 
-        std::shared_ptr<BTNode> tree = ECS::registry<AI>.get(slug).tree;
-        json treeJson;
-        tree->writeToJson(treeJson);
-        character[BTREE_KEY] = treeJson;
+        ECS::registry<AI>.get(slug).instance.writeToJson(character[BTREE_KEY]);
 
         toSave[CHARACTER_KEY][SLUG_KEY].push_back(character);
     }
@@ -242,10 +236,7 @@ void LoadSaveSystem::writeLevelFile(json& toSave)
         auto& motion = ECS::registry<Motion>.get(super_spider);
         json character = makeMotionJson(motion);
 
-        std::shared_ptr<BTNode> tree = ECS::registry<AI>.get(super_spider).tree;
-        json treeJson;
-        tree->writeToJson(treeJson);
-        character[BTREE_KEY] = treeJson;
+        ECS::registry<AI>.get(super_spider).instance.writeToJson(character[BTREE_KEY]);
 
         toSave[CHARACTER_KEY][SUPER_SPIDER_KEY].push_back(character);
     }
@@ -19,6 +19,7 @@
 #include "load_save.hpp"
 #include "parallax_background.hpp"
 #include "dialogue.hpp"
+#include "profiler.hpp"
 
 using Clock = std::chrono::high_resolution_clock;
 
@@ -83,12 +84,18 @@ int main()
 			DebugSystem::clearDebugComponents();
 			ai.step(elapsed_ms, window_size_in_game_units);
 			world.step(elapsed_ms, window_size_in_game_units);
+			// sync point, apply the removals queued while iterating
+			ECS::commands().flush();
 			physics.step(elapsed_ms, window_size_in_game_units);
+			ECS::commands().flush();
 			bg.step();
 			dialogue.step(elapsed_ms);
 		}
+		// input callbacks can queue changes while paused as well
+		ECS::commands().flush();
 
 		renderer.draw(window_size_in_game_units, elapsed_ms);
+		Profiler::endFrame(elapsed_ms, DebugSystem::in_debug_mode);
 	}
 
 	LoadSaveSystem::writePlayerFile();
@@ -58,7 +58,7 @@ protected:
 	// for iterating through the buttons vector
 	int activeButtonIndex;
 	// last mouse hover button, for deselecting on key press. assumes only one button can be active at a time (none overlap)
-	ECS::Entity activeButtonEntity;
+	ECS::Entity activeButtonEntity = ECS::Entity::null();
 	void resetButtons()
 	{
 		buttonEntities.clear();
@@ -17,31 +17,31 @@ struct Particle
 };
 struct BlurParticle
 {
-    ECS::Entity entity;
+    ECS::Entity entity = ECS::Entity::null();
     static bool canCreateNew;
     static float timer;
 };
 struct WeatherParticle
 {
-    ECS::Entity entity;
-    ECS::Entity parentEntity;
+    ECS::Entity entity = ECS::Entity::null();
+    ECS::Entity parentEntity = ECS::Entity::null();
     static int count;
     static float nextSpawn;
 };
 struct WeatherParentParticle
 {
     std::vector<ECS::Entity> particles;
-    ECS::Entity entity;
+    ECS::Entity entity = ECS::Entity::null();
     static float nextSpawn;
     static float count;
     static float timer;
 };
 struct RejectedStages
 {
-    ECS::Entity entity;
+    ECS::Entity entity = ECS::Entity::null();
     bool rejectedState2 = false;
     bool rejectedState3 = false;
 };
 struct Deprecated {
-    ECS::Entity entity;
+    ECS::Entity entity = ECS::Entity::null();
 };
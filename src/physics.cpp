@@ -1,6 +1,5 @@
 // internal
 #include "physics.hpp"
-#include "geometry.hpp"
 #include "render.hpp"
 #include "world.hpp"
 #include "debug.hpp"
@@ -13,20 +12,17 @@
 #include "tiles/water.hpp"
 #include "collectible.hpp"
 #include "particle.hpp"
+#include "broadphase.hpp"
+#include "hull.hpp"
+#include "profiler.hpp"
 
 // stlib
+#include <algorithm>
 #include <memory>
 #include <iostream>
 #include <cstdio>
 #include <math.h>
 
-// Returns the local bounding coordinates scaled by the current size of the entity 
-vec2 get_bounding_box(const Motion& motion)
-{
-	// fabs is to avoid negative scale due to the facing direction.
-	return { abs(motion.scale.x), abs(motion.scale.y) };
-}
-
 //given that the entity is moving from oldPos to newPos, update any tiles occupancy status
 void UpdateTileOccupancy(vec2 oldPos, vec2 newPos)
 {
@@ -200,267 +196,288 @@ vec2 PhysicsSystem::StepAroundCorner(ECS::Entity entity, float step_seconds, Mot
 	return C_t;
 }
 
-void bounceProjectileOffWall(Motion& projectileMotion, std::vector<ColoredVertex> projectileVertices, std::vector<ColoredVertex> wallVertices)
+// moves a projectile for step_seconds, bouncing it off the walls on the way.
+// Walls are grid cells, so instead of testing meshes the corners of the projectile's bounding box are traced through the tile grid.
+// The box is smaller than a tile, so it can only touch a wall after one of its corners entered it.
+void moveProjectile(ECS::Entity entity, Motion& motion, float step_seconds)
 {
-	//first we get the bounding box cooordinates for the wall
-	float minx = -1;
-	float miny = -1;
-	float maxx = -1;
-	float maxy = -1;
-	for (const auto& point : wallVertices)
-	{
-		auto pos = point.position;
-		minx = (minx == -1) ? pos.x : min(minx, pos.x);
-		miny = (miny == -1) ? pos.y : min(miny, pos.y);
-		maxx = (maxx == -1) ? pos.x : max(maxx, pos.x);
-		maxy = (maxy == -1) ? pos.y : max(maxy, pos.y);
-	}
+	// remember where it started and where it bounced, enemies are checked along the whole path
+	auto& sweeps = ECS::registry<SweptMotion>;
+	if (!sweeps.has(entity))
+		sweeps.emplace(entity);
+	SweptMotion& sweep = sweeps.get(entity);
+	sweep.start = motion.position;
+	sweep.bounces.clear();
 
-	auto bottomLeft = vec2(minx, maxy);
-	auto bottomRight = vec2(maxx, maxy);
-	auto upperRight = vec2(maxx, miny);
-	auto upperLeft = vec2(minx, miny);
-
-	std::vector<Geometry::Line> wallLines = std::vector<Geometry::Line>();
-	Geometry::Line bottomLine = { bottomLeft.x, bottomLeft.y, bottomRight.x, bottomRight.y };
-	Geometry::Line rightLine = { bottomRight.x, bottomRight.y, upperRight.x, upperRight.y };
-	Geometry::Line upperLine = { upperRight.x, upperRight.y, upperLeft.x, upperLeft.y };
-	Geometry::Line leftLine = { upperLeft.x, upperLeft.y, bottomLeft.x, bottomLeft.y };
-	wallLines.push_back(bottomLine);
-	wallLines.push_back(rightLine);
-	wallLines.push_back(upperLine);
-	wallLines.push_back(leftLine);
-
-	//for each point which is inside the wall, determine the distance it takes along
-	// the velocity to get it out of the bounding box.
-	float maxDistance = 0;
-	Geometry::Line reflectingLine{};
-	for (const auto& point : projectileVertices)
+	// fabs is to avoid negative scale due to the facing direction.
+	vec2 half = vec2(abs(motion.scale.x), abs(motion.scale.y)) / 2.f;
+	const vec2 corners[] = { { -half.x, -half.y }, { half.x, -half.y }, { half.x, half.y }, { -half.x, half.y } };
+	auto insideWall = [&](vec2 position)
 	{
-		if (Geometry::pointInsideConvexHull(vec2(point.position.x, point.position.y), wallLines))
+		for (const auto& corner : corners)
 		{
-			auto backwardVelocity = vec2(projectileMotion.velocity.x * (-2*TileSystem::getScale()), projectileMotion.velocity.y * (-2 * TileSystem::getScale()));
-			auto point2 = vec2(point.position.x, point.position.y) + backwardVelocity;
-			Geometry::Line projectileLine = { point.position.x, point.position.y, point2.x, point2.y };
-			//go through every wall line and find the one which intersects, then calculate the distance to that point.
-			bool foundWall = false;
-			for (auto wallLine : wallLines)
+			vec2 point = (position + corner) / TileSystem::getScale();
+			if (TileSystem::isWall(static_cast<int>(floor(point.x)), static_cast<int>(floor(point.y))))
+				return true;
+		}
+		return false;
+	};
+	// the earliest time within maxTime one of the corners enters a wall, and the wall face normal
+	auto firstHit = [&](vec2 position, float maxTime, float& hitTime, vec2& normal)
+	{
+		bool hit = false;
+		hitTime = maxTime;
+		for (const auto& corner : corners)
+		{
+			float t;
+			vec2 n;
+			if (TileSystem::raycastWall(position + corner, motion.velocity, hitTime, t, n) && (!hit || t < hitTime))
 			{
-				if (Geometry::linesIntersect(projectileLine, wallLine))
-				{
-					//assert(foundWall == false); //you should only intersect with one wallLine
-					foundWall = true;
-					//if they intersect, then this is the line that determines the distance my point needs to
-					// go back. So, determine what that distance is.
-					vec2 intersectionPoint = Geometry::intersectionOfLines(projectileLine, wallLine);
-					assert(Geometry::pointIsOnLine(intersectionPoint, wallLine));
-
-					float distance = glm::length(vec2(point.position.x, point.position.y) - intersectionPoint);
-					if (distance > maxDistance)
-					{
-						maxDistance = distance;
-						reflectingLine = wallLine;
-					}
-				}
+				hit = true;
+				hitTime = t;
+				normal = n;
 			}
-			
-			assert(foundWall);
-			
 		}
-	}
-	// take the velocity as a unit vector, multiply it by the negative of the maxDistance, and add that to the position.
-	float velocityLength = glm::length(projectileMotion.velocity);
-	if (velocityLength != 0)
+		return hit;
+	};
+
+	float speed = length(motion.velocity);
+	if (speed == 0.f)
+		return;
+
+	float remaining = step_seconds;
+	float hitTime;
+	vec2 normal;
+	if (insideWall(motion.position))
 	{
-		projectileMotion.position.x -= ((projectileMotion.velocity.x / velocityLength) * (maxDistance + 0.01)); //avoid collision
-		projectileMotion.position.y -= ((projectileMotion.velocity.y / velocityLength) * (maxDistance + 0.01));
+		// spawned (or loaded) overlapping a wall, find where it went in by retracing the last tile of its path
+		float rewind = TileSystem::getScale() / speed;
+		vec2 rewound = motion.position - motion.velocity * rewind;
+		if (!insideWall(rewound) && firstHit(rewound, rewind + remaining, hitTime, normal))
+		{
+			motion.position = rewound + motion.velocity * hitTime;
+			remaining = max(0.f, remaining + rewind - hitTime); // the time since it went in is spent moving out again
+		}
+		else
+		{
+			normal = -motion.velocity / speed;
+		}
+		motion.position += normal * 0.01f; //avoid collision
+		if (abs(normal.y) > abs(normal.x))
+			motion.velocity.y *= -1;
+		else
+			motion.velocity.x *= -1;
+		// the path that counts starts out of the wall
+		sweep.start = motion.position;
 	}
 
-	//reflect off the wall you colided with, which is either a vertical or a horizontal line.
-	if (reflectingLine == bottomLine || reflectingLine == upperLine)
+	// a fast projectile can bounce more than once in a step (e.g. in a corner), but don't loop forever
+	const int maxBounces = 16;
+	for (int bounces = 0; remaining > 0.f; bounces++)
 	{
-		projectileMotion.velocity.y *= -1;
+		if (!firstHit(motion.position, remaining, hitTime, normal))
+			break;
+		if (bounces == maxBounces)
+		{
+			// stuck bouncing, stay in front of the wall for the rest of the step
+			motion.position += motion.velocity * hitTime + normal * 0.01f;
+			remaining = 0.f;
+			break;
+		}
+		motion.position += motion.velocity * hitTime + normal * 0.01f; //avoid collision
+		//reflect off the wall you colided with, which is either a vertical or a horizontal line.
+		if (normal.x != 0)
+			motion.velocity.x *= -1;
+		else
+			motion.velocity.y *= -1;
+		remaining -= hitTime;
+		SweptMotion::Bounce bounce;
+		bounce.position = motion.position;
+		bounce.time = 1.f - remaining / step_seconds;
+		sweep.bounces.push_back(bounce);
 	}
-	else
+	motion.position += motion.velocity * remaining;
+}
+
+// makes sure the cached hull of the entity matches its current motion, creating it if needed
+static void updateHull(ECS::Entity entity, const Motion& motion)
+{
+	auto& hulls = ECS::registry<CollisionHull>;
+	if (!hulls.has(entity))
+		hulls.emplace(entity);
+	const Mesh& mesh = ECS::registry<MinShadedMeshRef>.get(entity).reference_to_cache->mesh;
+	if (hulls.get(entity).update(mesh, motion))
+		Profiler::frame.hullUpdates++;
+}
+
+// where the entity was at the fraction time of the step, following its bounces if it was swept
+static vec2 sweptPosition(const SweptMotion* sweep, const Motion& motion, float time)
+{
+	if (!sweep)
+		return motion.position;
+	vec2 from = sweep->start;
+	float fromTime = 0.f;
+	for (const auto& bounce : sweep->bounces)
 	{
-		projectileMotion.velocity.x *= -1;
+		if (time <= bounce.time)
+			return bounce.time > fromTime ? mix(from, bounce.position, (time - fromTime) / (bounce.time - fromTime)) : bounce.position;
+		from = bounce.position;
+		fromTime = bounce.time;
 	}
+	return fromTime < 1.f ? mix(from, motion.position, (time - fromTime) / (1.f - fromTime)) : motion.position;
 }
 
-bool collides(ECS::Entity& entity1, ECS::Entity& entity2, Motion& motion1, Motion& motion2, bool doPenetrationFree)
+// the time of the next bounce of a swept entity, after the ones before index
+static float nextBounceTime(const SweptMotion* sweep, size_t index)
 {
-	//first we get bounding boxes, and see if the meshes have a chance to collide
-	float other_r = std::sqrt(std::pow(get_bounding_box(motion1).x / 2.0f, 2.f) + std::pow(get_bounding_box(motion1).y / 2.0f, 2.f));
-	float my_r = std::sqrt(std::pow(get_bounding_box(motion2).x / 2.0f, 2.f) + std::pow(get_bounding_box(motion2).y / 2.0f, 2.f));
-	auto dp = motion1.position - motion2.position;
-	auto lengthdp = glm::length(dp);
-	auto radiusSum = other_r + my_r;
-	if (radiusSum < lengthdp)
+	return sweep && index < sweep->bounces.size() ? sweep->bounces[index].time : 1.f;
+}
+
+// whether the two entities touch, toi is the fraction of the step at which they first touch (1 if not swept)
+bool collides(ECS::Entity& entity1, ECS::Entity& entity2, Motion& motion1, Motion& motion2, float& toi, CollisionHull::Contact& contact)
+{
+	// both before taking references, creating a hull can move the others
+	updateHull(entity1, motion1);
+	updateHull(entity2, motion2);
+	const CollisionHull& hull1 = ECS::registry<CollisionHull>.get(entity1);
+	const CollisionHull& hull2 = ECS::registry<CollisionHull>.get(entity2);
+
+	auto dp = hull1.center - hull2.center;
+	auto radiusSum = hull1.radius + hull2.radius;
+
+	// fast movers are tested along the path they took this step, relative to each other, so they can't skip past anything.
+	// The path is straight between bounces, each straight part is swept on its own.
+	auto& sweeps = ECS::registry<SweptMotion>;
+	const SweptMotion* sweep1 = sweeps.has(entity1) ? &sweeps.get(entity1) : nullptr;
+	const SweptMotion* sweep2 = sweeps.has(entity2) ? &sweeps.get(entity2) : nullptr;
+	if (sweep1 || sweep2)
 	{
-		//bounding boxes don't collide, so no chance for meshes to.
+		float from = 0.f;
+		vec2 from1 = sweptPosition(sweep1, motion1, 0.f);
+		vec2 from2 = sweptPosition(sweep2, motion2, 0.f);
+		size_t next1 = 0;
+		size_t next2 = 0;
+		while (from < 1.f)
+		{
+			float to = min(nextBounceTime(sweep1, next1), nextBounceTime(sweep2, next2));
+			vec2 to1 = sweptPosition(sweep1, motion1, to);
+			vec2 to2 = sweptPosition(sweep2, motion2, to);
+			if (to > from)
+			{
+				// relative to each other, and where entity1 is at the end of this part relative to its hull
+				vec2 displacement = (to1 - from1) - (to2 - from2);
+				vec2 offset = (to1 - motion1.position) - (to2 - motion2.position);
+				//first we get bounding circles, and see if the meshes have a chance to collide
+				float partToi;
+				if (radiusSum + glm::length(displacement) >= glm::length(dp + offset)
+					&& CollisionHull::sweep(hull1, displacement, hull2, partToi, contact, offset))
+				{
+					toi = from + partToi * (to - from);
+					return true;
+				}
+			}
+			// carry on from the bounce points
+			from = to;
+			from1 = to1;
+			from2 = to2;
+			for (; sweep1 && next1 < sweep1->bounces.size() && sweep1->bounces[next1].time <= to; next1++)
+				from1 = sweep1->bounces[next1].position;
+			for (; sweep2 && next2 < sweep2->bounces.size() && sweep2->bounces[next2].time <= to; next2++)
+				from2 = sweep2->bounces[next2].position;
+		}
 		return false;
 	}
 
-	//now we get the vertices and indices for the two meshes, using the reduced meshes for faster detection.
-	auto mesh1_ptr = ECS::registry<MinShadedMeshRef>.get(entity1).reference_to_cache;
-	auto mesh2_ptr = ECS::registry<MinShadedMeshRef>.get(entity2).reference_to_cache;
-	auto vertices1 = std::vector<ColoredVertex>(mesh1_ptr->mesh.vertices); //copy
-	auto indices1 = mesh1_ptr->mesh.vertex_indices;
-	auto vertices2 = std::vector<ColoredVertex>(mesh2_ptr->mesh.vertices); //copy
-	auto indices2 = mesh2_ptr->mesh.vertex_indices;
-
-	//we need to adjust the vertices for the position and scale and angle.
-	Transform transform1;
-	transform1.translate(motion1.position);
-	transform1.rotate(motion1.angle);
-	transform1.scale(motion1.scale);
-	for (int i = 0; i < vertices1.size(); i++)
-	{
-		vec3 position = vec3(vertices1[i].position.x, vertices1[i].position.y, 1.0);
-		vertices1[i].position = transform1.mat * position;
-	}
-	Transform transform2;
-	transform2.translate(motion2.position);
-	transform2.rotate(motion2.angle);
-	transform2.scale(motion2.scale);
-	for (int i = 0; i < vertices2.size(); i++)
+	//first we get bounding boxes, and see if the meshes have a chance to collide
+	if (radiusSum < glm::length(dp))
 	{
-		vec3 position = vec3(vertices2[i].position.x, vertices2[i].position.y, 1.0);
-		vertices2[i].position = transform2.mat * position;
+		//bounding boxes don't collide, so no chance for meshes to.
+		return false;
 	}
 
-	//go over all the indices for the first mesh and make the lines between the vertices.
-	std::vector<Geometry::Line> lines1 = std::vector<Geometry::Line>();
-	for (int i = 0; i < indices1.size() - 1; i++)
+	if (any(lessThan(hull1.aabbMax, hull2.aabbMin)) || any(lessThan(hull2.aabbMax, hull1.aabbMin)))
 	{
-		auto vertex1 = vertices1[indices1[i]].position;
-		auto vertex2 = vertices1[indices1[i + 1]].position;
-		Geometry::Line line1 = { vertex1.x, vertex1.y, vertex2.x, vertex2.y }; //x0,y0,x1,y1
-		lines1.push_back(line1);
+		return false;
 	}
-	auto vertex1 = vertices1[indices1.back()].position;
-	auto vertex2 = vertices1[indices1[0]].position;
-	Geometry::Line line1 = { vertex1.x, vertex1.y, vertex2.x, vertex2.y }; //x0,y0,x1,y1
-	lines1.push_back(line1);
-
-	//go over all the indices for the second mesh and make the lines between the vertices.
-	std::vector<Geometry::Line> lines2 = std::vector<Geometry::Line>();
-	for (int i = 0; i < indices2.size() - 1; i++)
+
+	toi = 1.f;
+	return CollisionHull::overlap(hull1, hull2, contact);
+}
+
+// Collision layers, one bit each
+enum CollisionLayer : uint32_t
+{
+	LAYER_SNAIL = 1 << 0,
+	LAYER_SNAIL_PROJECTILE = 1 << 1,
+	LAYER_SLUG_PROJECTILE = 1 << 2,
+	LAYER_ENEMY = 1 << 3, // enemies that hurt the snail on contact
+	LAYER_OTHER_ENEMY = 1 << 4, // enemies that only projectiles hit (birds)
+	LAYER_WATER = 1 << 5,
+	LAYER_COLLECTIBLE = 1 << 6,
+};
+
+// Which layers collide with which, every rule applies in both directions.
+// Walls are not in here, projectiles bounce off them while moving (see moveProjectile).
+static const struct { uint32_t layer; uint32_t collidesWith; } collisionRules[] =
+{
+	{ LAYER_SNAIL, LAYER_ENEMY | LAYER_WATER | LAYER_SLUG_PROJECTILE | LAYER_COLLECTIBLE },
+	{ LAYER_SNAIL_PROJECTILE, LAYER_ENEMY | LAYER_OTHER_ENEMY | LAYER_SLUG_PROJECTILE },
+};
+
+// the collides-with mask of a layer, from the rules in both directions
+static uint32_t collidesWithMask(uint32_t layer)
+{
+	uint32_t mask = 0;
+	for (const auto& rule : collisionRules)
 	{
-		auto vertex3 = vertices2[indices2[i]].position;
-		auto vertex4 = vertices2[indices2[i + 1]].position;
-		Geometry::Line line2 = { vertex3.x, vertex3.y, vertex4.x, vertex4.y }; //x0,y0,x1,y1
-		lines2.push_back(line2);
-	}
-	auto vertex3 = vertices2[indices2.back()].position;
-	auto vertex4 = vertices2[indices2[0]].position;
-	Geometry::Line line2 = { vertex3.x, vertex3.y, vertex4.x, vertex4.y }; //x0,y0,x1,y1
-	lines2.push_back(line2);
-
-	//now we cover the case where one mesh is completely inside the other
-	vec2 vertexa = vec2(vertices1[0].position.x, vertices1[0].position.y);
-	vec2 vertexb = vec2(vertices2[0].position.x, vertices2[0].position.y);
-	if (Geometry::pointInsideConvexHull(vertexa, lines2) || Geometry::pointInsideConvexHull(vertexb, lines1))
-	{
-		if (doPenetrationFree)
-		{
-			// edited this to fit SlugProjectile...
-			if (ECS::registry<Projectile>.has(entity1))
-			{
-				//projectile is entity1, wall is entity2
-				bounceProjectileOffWall(motion1, vertices1, vertices2);
-			}
-			else if (ECS::registry<SlugProjectile>.has(entity1)) {
-				bounceProjectileOffWall(motion1, vertices1, vertices2);
-			}
-			else if (ECS::registry<SlugProjectile>.has(entity2)) {
-				bounceProjectileOffWall(motion2, vertices2, vertices1);
-			}
-			else
-			{
-                //projectile is entity2, wall is entity1
-				bounceProjectileOffWall(motion2, vertices2, vertices1);
-			}
-		}
-		return true;
+		if (rule.layer == layer)
+			mask |= rule.collidesWith;
+		if (rule.collidesWith & layer)
+			mask |= rule.layer;
 	}
+	return mask;
+}
 
-	// go over every pair of lines and see if they intersect.
-	for (auto line3 : lines1)
+// The collision filter of an entity, given its components
+static CollisionFilter collisionFilterOf(const ECS::Signature& signature)
+{
+	// the first layer whose components the entity has, in order of priority
+	static const struct { ECS::Signature components; uint32_t layer; bool isStatic; } layers[] =
 	{
-		for (auto line4 : lines2)
+		{ ECS::mask<Snail>(), LAYER_SNAIL, false },
+		{ ECS::mask<SnailProjectile>(), LAYER_SNAIL_PROJECTILE, false },
+		{ ECS::mask<SlugProjectile>(), LAYER_SLUG_PROJECTILE, false },
+		{ ECS::mask<Spider, Slug, SuperSpider, Fish>(), LAYER_ENEMY, false },
+		{ ECS::mask<Enemy>(), LAYER_OTHER_ENEMY, false },
+		{ ECS::mask<WaterTile>(), LAYER_WATER, true },
+		{ ECS::mask<Collectible>(), LAYER_COLLECTIBLE, false },
+	};
+	// dying entities and equipped collectibles don't collide with anything
+	static const ECS::Signature disabled = ECS::mask<DeathTimer, NoCollide>();
+
+	CollisionFilter filter;
+	if ((signature & disabled).any())
+		return filter;
+	for (const auto& entry : layers)
+	{
+		if ((signature & entry.components).any())
 		{
-			if (Geometry::linesIntersect(line3, line4)) 
-			{
-				if (doPenetrationFree)
-				{
-					if (ECS::registry<Projectile>.has(entity1))
-					{
-						//projectile is entity1, wall is entity2
-						bounceProjectileOffWall(motion1, vertices1, vertices2);
-					}
-					else if (ECS::registry<SlugProjectile>.has(entity1)) {
-						bounceProjectileOffWall(motion1, vertices1, vertices2);
-					}
-					else if (ECS::registry<SlugProjectile>.has(entity2)) {
-						bounceProjectileOffWall(motion2, vertices2, vertices1);
-					}
-					else
-					{
-						bounceProjectileOffWall(motion2, vertices2, vertices1);
-					}
-				}
-				return true;
-			}
+			filter.layer = entry.layer;
+			filter.collidesWith = collidesWithMask(entry.layer);
+			filter.isStatic = entry.isStatic;
+			break;
 		}
 	}
-
-	return false;
+	return filter;
 }
 
-//returns true if entity_i and entity_j is a (Projectile,WallTile) pair in either order
-bool isProjectileAndWall(ECS::Entity entity_i, ECS::Entity entity_j)
-{
-	return (ECS::registry<Projectile>.has(entity_i) && ECS::registry<WallTile>.has(entity_j)) ||
-		(ECS::registry<WallTile>.has(entity_i) && ECS::registry<Projectile>.has(entity_j)) ||
-		(ECS::registry<SlugProjectile>.has(entity_i) && ECS::registry<WallTile>.has(entity_j)) ||
-		(ECS::registry<WallTile>.has(entity_i) && ECS::registry<SlugProjectile>.has(entity_j));
-}
-
-//returns true if we have a possibility of caring if entity_i and entity_j collide
+//returns true if we still care if entity_i and entity_j collide, handling an earlier collision this step can start one dying
 bool shouldCheckCollision(ECS::Entity entity_i, ECS::Entity entity_j)
 {
-	if (ECS::registry<DeathTimer>.has(entity_i) || ECS::registry<DeathTimer>.has(entity_j))
-		return false;
-
-	bool isValidSnailCollision_i = ECS::registry<Snail>.has(entity_i) &&
-		(ECS::registry<Spider>.has(entity_j) || ECS::registry<WaterTile>.has(entity_j) || ECS::registry<SlugProjectile>.has(entity_j) ||
-			ECS::registry<Slug>.has(entity_j) || ECS::registry<SuperSpider>.has(entity_j) || ECS::registry<Fish>.has(entity_j) ||
-                (!ECS::registry<NoCollide>.has(entity_j) && ECS::registry<Collectible>.has(entity_j)));
-
-	bool isValidSnailCollision_j = ECS::registry<Snail>.has(entity_j) &&
-		(ECS::registry<Spider>.has(entity_i) || ECS::registry<WaterTile>.has(entity_i) || ECS::registry<SlugProjectile>.has(entity_i) ||
-			ECS::registry<Slug>.has(entity_i) || ECS::registry<SuperSpider>.has(entity_i) || ECS::registry<Fish>.has(entity_i) ||
-		        (!ECS::registry<NoCollide>.has(entity_i) && ECS::registry<Collectible>.has(entity_i)));
-
-	bool isValidSnailProjectileCollision_i = ECS::registry<SnailProjectile>.has(entity_i) &&
-		(ECS::registry<Enemy>.has(entity_j) || ECS::registry<WallTile>.has(entity_j) || 
-			ECS::registry<SlugProjectile>.has(entity_j));
-
-	bool isValidSnailProjectileCollision_j = ECS::registry<SnailProjectile>.has(entity_j) &&
-		(ECS::registry<Enemy>.has(entity_i) || ECS::registry<WallTile>.has(entity_i) ||
-			ECS::registry<SlugProjectile>.has(entity_i));
-
-	bool isValidSlugProjectileCollision_i = ECS::registry<SlugProjectile>.has(entity_i) &&
-		(ECS::registry<WallTile>.has(entity_j));
-
-	bool isValidSlugProjectileCollision_j = ECS::registry<SlugProjectile>.has(entity_j) &&
-		(ECS::registry<WallTile>.has(entity_i));
-	
-
-	return isValidSnailCollision_i || isValidSnailCollision_j || 
-		isValidSnailProjectileCollision_i || isValidSnailProjectileCollision_j ||
-		isValidSlugProjectileCollision_i || isValidSlugProjectileCollision_j;
+	static const ECS::Signature deathTimer = ECS::mask<DeathTimer>();
+	const auto& signature_i = ECS::ContainerInterface::signature_of(entity_i);
+	const auto& signature_j = ECS::ContainerInterface::signature_of(entity_j);
+	return ((signature_i | signature_j) & deathTimer).none();
 }
 
 void PhysicsSystem::stepToDestinationAroundCorner(ECS::Entity entity, float step_seconds) 
@@ -575,6 +592,13 @@ void PhysicsSystem::step(float elapsed_ms, vec2 window_size_in_game_units)
 {
     (void)window_size_in_game_units;
     float step_seconds = 1.0f * (elapsed_ms / 1000.f);
+    contacts.clear();
+    // nothing has been swept yet this step
+    ECS::view<SweptMotion, Motion>().each([](ECS::Entity, SweptMotion& sweep, Motion& motion)
+    {
+        sweep.start = motion.position;
+        sweep.bounces.clear();
+    });
     WeatherParentParticle::nextSpawn -= elapsed_ms;
     WeatherParticle::nextSpawn -= elapsed_ms;
     bool areAllDeprecated = true;
@@ -601,7 +625,7 @@ void PhysicsSystem::step(float elapsed_ms, vec2 window_size_in_game_units)
         int particlesSize = element.particles.size();
         if(isDeprecated) {
             if(particlesSize == 0)
-                ECS::ContainerInterface::remove_all_components_of(entity);
+                ECS::commands().destroy(entity);
         } else {
             if(particlesSize < WeatherParticle::count && WeatherParticle::nextSpawn < 0)
             {
@@ -654,7 +678,7 @@ void PhysicsSystem::step(float elapsed_ms, vec2 window_size_in_game_units)
                         ++it;
                     }
                 }
-                ECS::ContainerInterface::remove_all_components_of(entity);
+                ECS::commands().destroy(entity);
                 continue;
             } else if(!isDeprecated && WorldSystem::offScreenExceptNegativeYWithBuffer(motion.position, window_size_in_game_units, cameraOffset, 250)) {
                     float xValue = 0;
@@ -683,17 +707,15 @@ void PhysicsSystem::step(float elapsed_ms, vec2 window_size_in_game_units)
     }
     
     //now we update the state of the entities with regards to which entites are rounding the corner
-    for (auto entity : ECS::registry<Destination>.entities)
+    ECS::view<Destination, Motion, ECS::Not<CornerMotion>>().each([&](ECS::Entity entity, Destination& dest, Motion& motion)
     {
-        auto& motion = ECS::registry<Motion>.get(entity);
-        if (!ECS::registry<CornerMotion>.has(entity) && areRoundingCorner(motion))
+        if (areRoundingCorner(motion))
         {
             //then initialize rounding the corner
-            auto& dest = ECS::registry<Destination>.get(entity);
             SetupCornerMovement(entity, dest);
             SetupNextCornerSegment(entity, motion);
         }
-    }
+    });
     // Move entities based on how much time has passed, this is to (partially) avoid
 	// having entities move at different speed based on the machine.
 
@@ -701,12 +723,10 @@ void PhysicsSystem::step(float elapsed_ms, vec2 window_size_in_game_units)
     if (turnType == PLAYER_WAITING)
     {
         // Projectile previews
-        for (auto entity : ECS::registry<SnailProjectile::Preview>.entities)
+        ECS::view<SnailProjectile::Preview, Motion>().each([&](ECS::Entity entity, SnailProjectile::Preview&, Motion& motion)
         {
-            auto& motion = ECS::registry<Motion>.get(entity);
-            vec2 velocity = motion.velocity;
-            motion.position += velocity * step_seconds;
-        }
+            moveProjectile(entity, motion, step_seconds);
+        });
         for (auto entity : ECS::registry<Projectile>.entities)
         {
             bool isSnailProjectile = ECS::registry<SnailProjectile>.has(entity);
@@ -717,7 +737,7 @@ void PhysicsSystem::step(float elapsed_ms, vec2 window_size_in_game_units)
 				{
 					notify(Event(Event::PROJECTILE_POPPED));
 				}
-                ECS::ContainerInterface::remove_all_components_of(entity);
+                ECS::commands().destroy(entity);
             }
         }
     }
@@ -725,7 +745,7 @@ void PhysicsSystem::step(float elapsed_ms, vec2 window_size_in_game_units)
 	else if (turnType == PLAYER_UPDATE)
     {
 
-        auto& snailEntity = ECS::registry<Snail>.entities[0];
+        ECS::Entity snailEntity = ECS::registry<Snail>.entities[0];
 		if (ECS::registry<Destination>.has(snailEntity)) //don't want to do any stepping if we don't have a destination
 		{
 			if (ECS::registry<CornerMotion>.has(snailEntity))
@@ -750,22 +770,20 @@ void PhysicsSystem::step(float elapsed_ms, vec2 window_size_in_game_units)
         for (auto entity : ECS::registry<SnailProjectile>.entities)
         {
             auto& motion = ECS::registry<Motion>.get(entity);
-            vec2 velocity = motion.velocity;
-            motion.position += velocity * step_seconds;
+            moveProjectile(entity, motion, step_seconds);
             auto& proj = ECS::registry<Projectile>.get(entity);
             if(proj.moved > Projectile::snailProjectileMaxMoves) {
-                ECS::ContainerInterface::remove_all_components_of(entity);
+                ECS::commands().destroy(entity);
             }
         }
 		// making sure slug projectiles move
 		for (auto entity : ECS::registry<SlugProjectile>.entities)
 		{
 			auto& motion = ECS::registry<Motion>.get(entity);
-			vec2 velocity = motion.velocity;
-			motion.position += velocity * step_seconds;
+			moveProjectile(entity, motion, step_seconds);
             auto& proj = ECS::registry<Projectile>.get(entity);
             if(proj.moved > Projectile::aiProjectileMaxMoves) {
-                ECS::ContainerInterface::remove_all_components_of(entity);
+                ECS::commands().destroy(entity);
             }
 		}
 
@@ -785,16 +803,17 @@ void PhysicsSystem::step(float elapsed_ms, vec2 window_size_in_game_units)
 		if (ECS::registry<Destination>.components.size() == 0) {
 			// check if 2 spiders end turn in the same position
 			// this means that after the turn where to spiders clash, then they turn into a superspider
-			for (int i = 0; i < ECS::registry<Spider>.entities.size(); i++) {
-				for (int j = i + 1; j < ECS::registry<Spider>.entities.size(); j++) {
-					auto& motion1 = ECS::registry<Motion>.get(ECS::registry<Spider>.entities[i]);
-					auto& motion2 = ECS::registry<Motion>.get(ECS::registry<Spider>.entities[j]);
-					float scale = TileSystem::getScale();
+			// spiders are a tag, copy them out for indexed access
+			std::vector<ECS::Entity> spiders(ECS::registry<Spider>.entities.begin(), ECS::registry<Spider>.entities.end());
+			for (size_t i = 0; i < spiders.size(); i++) {
+				for (size_t j = i + 1; j < spiders.size(); j++) {
+					auto& motion1 = ECS::registry<Motion>.get(spiders[i]);
+					auto& motion2 = ECS::registry<Motion>.get(spiders[j]);
 					if (motion1.position == motion2.position) {
-						ECS::Entity e1 = ECS::registry<Spider>.entities[i];
-						ECS::Entity e2 = ECS::registry<Spider>.entities[j];
-						notify(Event(Event::COLLISION, e1, e2));
-						notify(Event(Event::COLLISION, e2, e1));
+						CollisionContact contact;
+						contact.entity = spiders[i];
+						contact.other = spiders[j];
+						contacts.push_back(contact);
 					}
 				}
 			}
@@ -820,64 +839,75 @@ void PhysicsSystem::step(float elapsed_ms, vec2 window_size_in_game_units)
 	// Visualization for debugging the position and scale of objects
 	if (DebugSystem::in_debug_mode)
 	{
-		auto& motion_container = ECS::registry<Motion>;
-		for (int i = motion_container.components.size() - 1; i >= 0; i--)
+		// ignore overlays and backgrounds, the lines created here are not visited
+		ECS::view<Motion, ECS::Not<Overlay>, ECS::Not<Parallax>>().each([](ECS::Entity, Motion& motion)
 		{
-			Motion& motion = motion_container.components[i];
-			ECS::Entity entity = motion_container.entities[i];
-
-			// ignore overlays
-			if (ECS::registry<Overlay>.has(entity))
-				continue;
-
-			// ignore backgrounds
-			if (ECS::registry<Parallax>.has(entity))
-				continue;
-
-			// draw a cross at the position of all objects
+			// draw a cross at the position of all objects (copied, creating a line can reallocate the motions)
+			auto position = motion.position;
 			auto scale_horizontal_line = motion.scale;
 			scale_horizontal_line.y *= 0.1f;
 			auto scale_vertical_line = motion.scale;
 			scale_vertical_line.x *= 0.1f;
-			DebugSystem::createLine(motion.position, scale_horizontal_line);
-			DebugSystem::createLine(motion.position, scale_vertical_line);
-		}
+			DebugSystem::createLine(position, scale_horizontal_line);
+			DebugSystem::createLine(position, scale_vertical_line);
+		});
 	}
 
-	// Check for collisions between all moving entities
+	// Check for collisions between the entities that share a broadphase cell and whose layers collide
+	Broadphase::update(collisionFilterOf);
+	const auto& candidates = Broadphase::candidatePairs();
+	Profiler::frame.collisionPairs += static_cast<int>(candidates.size());
 	auto& motion_container = ECS::registry<Motion>;
-	// for (auto [i, motion_i] : enumerate(motion_container.components)) // in c++ 17 we will be able to do this instead of the next three lines
-	for (unsigned int i = 0; i < motion_container.components.size(); i++)
+	for (const auto& candidate : candidates)
 	{
-		Motion& motion_i = motion_container.components[i];
-		ECS::Entity entity_i = motion_container.entities[i];
-		for (unsigned int j = i + 1; j < motion_container.components.size(); j++)
+		Motion& motion_i = motion_container.components[candidate.first];
+		ECS::Entity entity_i = motion_container.entities[candidate.first];
+		Motion& motion_j = motion_container.components[candidate.second];
+		ECS::Entity entity_j = motion_container.entities[candidate.second];
+		float toi;
+		CollisionHull::Contact hullContact;
+		if (shouldCheckCollision(entity_i, entity_j) && collides(entity_i, entity_j, motion_i, motion_j, toi, hullContact))
 		{
-			Motion& motion_j = motion_container.components[j];
-			ECS::Entity entity_j = motion_container.entities[j];
-      if (shouldCheckCollision(entity_i, entity_j))
-			{
-				bool doPenetrationFree = isProjectileAndWall(entity_i, entity_j);
-				if (collides(entity_i, entity_j, motion_i, motion_j, doPenetrationFree))
-				{
-                    if((entity_i.id != WaterTile::splashEntityID && entity_j.id != WaterTile::splashEntityID) && (ECS::registry<WaterTile>.has(entity_i) || ECS::registry<WaterTile>.has(entity_j))) {
-                        ECS::Entity e = ECS::registry<WaterTile>.has(entity_i) ? entity_i : entity_j;
-                        notify(Event(Event::SPLASH, e));
-                    } else {
-                        notify(Event(Event::COLLISION, entity_i, entity_j));
-                        notify(Event(Event::COLLISION, entity_j, entity_i));
-                        //notify both entities of collision
-                        notify(Event(Event::COLLISION, entity_i, entity_j));
-                        notify(Event(Event::COLLISION, entity_j, entity_i));
-                    }
-                    
-				}
-			}
+			CollisionContact contact;
+			contact.entity = entity_i;
+			contact.other = entity_j;
+			contact.normal = hullContact.normal;
+			contact.depth = hullContact.depth;
+			contact.toi = toi;
+			contacts.push_back(contact);
 		}
 	}
-}
 
-PhysicsSystem::Collision::Collision(ECS::Entity& other)
-{
-	this->other = other;
+	if (contacts.empty())
+	{
+		return;
+	}
+
+	// each pair once, lower id first, keeping the earliest touch
+	for (auto& contact : contacts)
+	{
+		if (contact.other.id < contact.entity.id)
+		{
+			std::swap(contact.entity, contact.other);
+			contact.normal = -contact.normal;
+		}
+	}
+	std::sort(contacts.begin(), contacts.end(), [](const CollisionContact& a, const CollisionContact& b)
+	{
+		if (a.entity.id != b.entity.id)
+			return a.entity.id < b.entity.id;
+		if (a.other.id != b.other.id)
+			return a.other.id < b.other.id;
+		return a.toi < b.toi;
+	});
+	contacts.erase(std::unique(contacts.begin(), contacts.end(), [](const CollisionContact& a, const CollisionContact& b)
+	{
+		return a.entity.id == b.entity.id && a.other.id == b.other.id;
+	}), contacts.end());
+
+	// handled in the order they happened during the step, so that e.g. a projectile passing two enemies
+	// in one long frame hits the first one, like it would have with shorter frames
+	std::stable_sort(contacts.begin(), contacts.end(), [](const CollisionContact& a, const CollisionContact& b) { return a.toi < b.toi; });
+	// one dispatch for the whole step
+	notify(Event(Event::CONTACTS, contacts));
 }
@@ -3,14 +3,19 @@
 #include "common.hpp"
 #include "tiny_ecs.hpp"
 #include "subject.hpp"
+#include "event.hpp"
 
 #include <random>
+#include <vector>
 #include <functional>
 
 #define SDL_MAIN_HANDLED
 #include <SDL.h>
 #include <SDL_mixer.h>
 
+//given that the entity is moving from oldPos to newPos, update any tiles occupancy status
+void UpdateTileOccupancy(vec2 oldPos, vec2 newPos);
+
 // A simple physics system that moves rigid bodies and checks for collision
 class PhysicsSystem : public Subject
 {
@@ -27,15 +32,10 @@ public:
     
 	void step(float elapsed_ms, vec2 window_size_in_game_units);
 
-	// Stucture to store collision information
-	struct Collision
-	{
-		// Note, the first object is stored in the ECS container.entities
-		ECS::Entity other; // the second object involved in the collision
-		Collision(ECS::Entity& other);
-	};
-
 private:
+	// contacts found this step, kept around to reuse the memory
+	std::vector<CollisionContact> contacts;
+
 	void SetupCornerMovement(ECS::Entity entity, Destination& dest);
 	void SetupNextCornerSegment(ECS::Entity entity, Motion& motion);
 	vec2 StepAroundCorner(ECS::Entity entity, float step_seconds, Motion& motion);
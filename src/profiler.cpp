@@ -0,0 +1,65 @@
+// header
+#include "profiler.hpp"
+
+// stlib
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+
+constexpr float Profiler::REPORT_INTERVAL_MS;
+
+FrameStats Profiler::frame;
+FrameStats Profiler::window;
+FrameStats Profiler::lastWindow;
+int Profiler::windowFrames = 0;
+int Profiler::lastWindowFrames = 0;
+float Profiler::windowMs = 0.f;
+float Profiler::lastWindowMs = 0.f;
+
+void Profiler::endFrame(float elapsed_ms, bool report)
+{
+	window.renderSorts += frame.renderSorts;
+	window.collisionPairs += frame.collisionPairs;
+	window.hullUpdates += frame.hullUpdates;
+	window.aiTicks += frame.aiTicks;
+	window.aiMicroseconds += frame.aiMicroseconds;
+	// the longest the queue got
+	window.aiDeferred = std::max(window.aiDeferred, frame.aiDeferred);
+	window.pathCacheHits += frame.pathCacheHits;
+	window.pathCacheRepairs += frame.pathCacheRepairs;
+	window.pathCacheMisses += frame.pathCacheMisses;
+	window.fieldsSpeculated += frame.fieldsSpeculated;
+	window.fieldsComputed += frame.fieldsComputed;
+	frame = FrameStats();
+
+	windowFrames++;
+	windowMs += elapsed_ms;
+	if (windowMs < REPORT_INTERVAL_MS)
+		return;
+
+	lastWindow = window;
+	lastWindowFrames = windowFrames;
+	lastWindowMs = windowMs;
+	window = FrameStats();
+	windowFrames = 0;
+	windowMs = 0.f;
+
+	if (report)
+		std::cout << summary() << std::endl;
+}
+
+std::string Profiler::summary()
+{
+	std::stringstream ss;
+	float avgMs = lastWindowFrames > 0 ? lastWindowMs / lastWindowFrames : 0.f;
+	ss << "[profiler] " << lastWindowFrames << " frames, " << avgMs << " ms/frame"
+	   << ", render sorts: " << lastWindow.renderSorts << "/" << lastWindowFrames
+	   << ", collision pairs/frame: " << (lastWindowFrames > 0 ? lastWindow.collisionPairs / lastWindowFrames : 0)
+	   << ", hull updates/frame: " << (lastWindowFrames > 0 ? lastWindow.hullUpdates / lastWindowFrames : 0)
+	   << ", AI ticks: " << lastWindow.aiTicks << " in " << lastWindow.aiMicroseconds << " us"
+	   << ", AI deferred peak: " << lastWindow.aiDeferred
+	   << ", path cache hits/repairs/misses: " << lastWindow.pathCacheHits << "/" << lastWindow.pathCacheRepairs
+	   << "/" << lastWindow.pathCacheMisses
+	   << ", snail fields speculated/computed: " << lastWindow.fieldsSpeculated << "/" << lastWindow.fieldsComputed;
+	return ss.str();
+}
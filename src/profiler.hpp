@@ -0,0 +1,51 @@
+#pragma once
+
+// stlib
+#include <string>
+
+// Counters for the work done by the systems in a single frame, reset at the end of every frame
+struct FrameStats
+{
+	// number of frames in which the render order had to be re-sorted
+	int renderSorts = 0;
+	// candidate pairs handed from the collision broadphase to the narrowphase
+	int collisionPairs = 0;
+	// collision hulls recomputed because their entity moved (or was new)
+	int hullUpdates = 0;
+	// enemies that took their turn, and the time it took
+	int aiTicks = 0;
+	int aiMicroseconds = 0;
+	// enemies left for the next frames because the AI ran out of its frame budget
+	int aiDeferred = 0;
+	// enemy paths reused from the path cache as they were, cut from a longer cached path, or found again
+	int pathCacheHits = 0;
+	int pathCacheRepairs = 0;
+	int pathCacheMisses = 0;
+	// distance fields to the snail taken from the speculation, and computed during the enemy turn
+	int fieldsSpeculated = 0;
+	int fieldsComputed = 0;
+};
+
+class Profiler
+{
+public:
+	// the counters of the current frame, systems add to these while stepping
+	static FrameStats frame;
+
+	// accumulates the current frame into the reporting window and resets it,
+	// prints the averages about once per second if report is set
+	static void endFrame(float elapsed_ms, bool report);
+
+	// summary of the last completed reporting window
+	static std::string summary();
+
+private:
+	static constexpr float REPORT_INTERVAL_MS = 1000.f;
+
+	static FrameStats window;
+	static FrameStats lastWindow;
+	static int windowFrames;
+	static int lastWindowFrames;
+	static float windowMs;
+	static float lastWindowMs;
+};
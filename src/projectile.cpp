@@ -77,9 +77,9 @@ ECS::Entity SnailProjectile::createProjectile(Motion motion, bool preview /* = f
 
 void SnailProjectile::Preview::removeCurrent()
 {
-    for (auto& entity : ECS::registry<SnailProjectile::Preview>.entities)
+    for (auto entity : ECS::registry<SnailProjectile::Preview>.entities)
     {
-        ECS::ContainerInterface::remove_all_components_of(entity);
+        ECS::commands().destroy(entity);
     }
 }
 
@@ -7,6 +7,7 @@
 #include "render.hpp"
 #include "text.hpp"
 #include "menus/level_select.hpp"
+#include "profiler.hpp"
 
 #include <iostream>
 
@@ -358,7 +359,9 @@ void RenderSystem::draw(vec2 window_size_in_game_units, float elapsed_ms)
 	mat3 overlay_projection_2D = projection2D(window_size_in_game_units, { 0, 0 });
 
 	// Sort meshes for correct asset drawing order
-	ECS::registry<ShadedMeshRef>.sort(renderCmp);
+	// only sorts the meshes added since the last frame, nothing to do if none were
+	if (ECS::registry<ShadedMeshRef>.sort_incremental(renderCmp))
+		Profiler::frame.renderSorts++;
 
 	// bind it
 	glBindFramebuffer(GL_FRAMEBUFFER, frame_buffer_2);
@@ -375,25 +378,16 @@ void RenderSystem::draw(vec2 window_size_in_game_units, float elapsed_ms)
 	// first we draw all objects that block light onto a temporary texture.
 
 	 //Draw all textured meshes that have a position and size component, and are occluders
-	for (ECS::Entity entity : ECS::registry<ShadedMeshRef>.entities)
+	ECS::view<ShadedMeshRef, Motion, Occluder, ECS::Not<LevelSelectTag>>().each_in_order_of<ShadedMeshRef>(
+		[&](ECS::Entity entity, ShadedMeshRef&, Motion&, Occluder&)
 	{
-		if (!ECS::registry<Motion>.has(entity))
-			continue;
-
-		if (ECS::registry<LevelSelectTag>.has(entity))
-			continue;
-
-		if (!ECS::registry<Occluder>.has(entity))
-			continue;
-		
-		// Note, its not very efficient to access elements indirectly via the entity albeit iterating through all Sprites in sequence
 		if (ECS::registry<Overlay>.has(entity))
 			drawTexturedMesh(entity, overlay_projection_2D, elapsed_ms, true);
 		else
 			drawTexturedMesh(entity, projection_2D, elapsed_ms, true);
 
 		gl_has_errors();
-	}
+	});
 
 	//bind the new frame buffer
 	glBindFramebuffer(GL_FRAMEBUFFER, frame_buffer);
@@ -408,16 +402,11 @@ void RenderSystem::draw(vec2 window_size_in_game_units, float elapsed_ms)
 	gl_has_errors();
 
 	 //Draw all textured meshes that have a position and size component
-	for (ECS::Entity entity : ECS::registry<ShadedMeshRef>.entities)
+	// overlays are drawn after the shadow
+	ECS::view<ShadedMeshRef, Motion, ECS::Not<Overlay>>().each_in_order_of<ShadedMeshRef>(
+		[&](ECS::Entity entity, ShadedMeshRef&, Motion&)
 	{
-		if (!ECS::registry<Motion>.has(entity))
-			continue;
-		
-		// Note, its not very efficient to access elements indirectly via the entity albeit iterating through all Sprites in sequence
-		if (ECS::registry<Overlay>.has(entity))
-			// draw overlays after shadow
-			continue;
-		else if (ECS::registry<Parallax>.has(entity))
+		if (ECS::registry<Parallax>.has(entity))
 			drawTexturedMesh(entity, projection2D(window_size_in_game_units, cameraOffset / static_cast<float>(ECS::registry<Parallax>.get(entity).layer)), elapsed_ms, false);
         else if (ECS::registry<WeatherParentParticle>.has(entity))
             drawTexturedMeshForParticles(entity, window_size_in_game_units, projection_2D, elapsed_ms);
@@ -425,21 +414,19 @@ void RenderSystem::draw(vec2 window_size_in_game_units, float elapsed_ms)
 			drawTexturedMesh(entity, projection_2D, elapsed_ms, false);
 
 		gl_has_errors();
-	}
+	});
 
 	//draw frame_buffer_2 to frame_buffer.
 	drawShadowScreen();
 
 	//Draw all Overlay textured meshes that have a position and size component
-	for (ECS::Entity entity : ECS::registry<ShadedMeshRef>.entities)
+	ECS::view<ShadedMeshRef, Motion, Overlay>().each_in_order_of<ShadedMeshRef>(
+		[&](ECS::Entity entity, ShadedMeshRef&, Motion&, Overlay&)
 	{
-		if (!ECS::registry<Motion>.has(entity) || !ECS::registry<Overlay>.has(entity))
-			continue;
-		else
-			drawTexturedMesh(entity, overlay_projection_2D, elapsed_ms, false);
+		drawTexturedMesh(entity, overlay_projection_2D, elapsed_ms, false);
 
 		gl_has_errors();
-	}
+	});
 
 	//use a shader where it goes through every single pixel, and determines if we should have a shadow on top of it.
 
@@ -411,6 +411,7 @@ void Mesh::loadFromMinOBJFile(std::string obj_path) {
 	// make sure we start from scratch
 	this->vertices.clear();
 	this->vertex_indices.clear();
+	this->face_offsets.clear();
 
 	auto obj_file = std::ifstream{ obj_path };
 	if (!obj_file) {
@@ -447,6 +448,7 @@ void Mesh::loadFromMinOBJFile(std::string obj_path) {
 			out_normals.push_back(normal);
 		}
 		else if (firstWord == "f") {
+			face_offsets.push_back(static_cast<uint16_t>(vertex_indices.size()));
 			while (true)
 			{
 				//read however many entries there are.
@@ -124,6 +124,9 @@ struct Mesh
 	GLResource<VERTEX_ARRAY> vao;
 	std::vector<ColoredVertex> vertices;
 	std::vector<uint16_t> vertex_indices;
+	// where each face starts in vertex_indices, only filled in by loadFromMinOBJFile. Every face of a reduced mesh is a
+	// convex outline of its own, collision tests go over them one at a time.
+	std::vector<uint16_t> face_offsets;
 };
 
 struct ScreenState
@@ -43,13 +43,9 @@ ECS::Entity Spider::createExplodingSpider(Motion givenMotion, ECS::Entity entity
     DeathTimer& dt = ECS::registry<DeathTimer>.emplace(entity);
     dt.counter_ms = Particle::timer*10;
     // Adding Behaviour Tree to Spider
-    // Maybe add some registry that keeps track of trees??
-    std::shared_ptr <BTNode> lfs = std::make_unique<LookForSnail>();
-    std::shared_ptr <BTNode> isr = std::make_unique<IsSnailInRange>();
-    std::shared_ptr <BTNode> tree = std::make_unique<BTSequence>(std::vector<std::shared_ptr <BTNode>>({ isr, lfs }));
-    tree->init(entity);
     auto& ai = ECS::registry<AI>.get(entity);
-    ai.tree = tree;
+    ai.tree = &BTDefinition::spider();
+    ai.instance = ai.tree->start(entity);
     return entity;
 }
 
@@ -74,7 +70,7 @@ ECS::Entity Spider::createSpider(vec2 position, ECS::Entity entity)
     return entity;
 }
 
-ECS::Entity Spider::createSpider(Motion motion, ECS::Entity entity, std::shared_ptr<BTNode> tree /* = nullptr */)
+ECS::Entity Spider::createSpider(Motion motion, ECS::Entity entity)
 {
     // Create rendering primitives
     std::string key = "spider";
@@ -105,18 +101,10 @@ ECS::Entity Spider::createSpider(Motion motion, ECS::Entity entity, std::shared_
     ECS::registry<DirectionInput>.emplace(entity);
 
 
-    // Adding Behaviour Tree to Spider
-    // Maybe add some registry that keeps track of trees??
-    if (!tree)
-    {
-        std::shared_ptr <BTNode> lfs = std::make_unique<LookForSnail>(false);
-        std::shared_ptr <BTNode> isr = std::make_unique<IsSnailInRange>();
-        tree = std::make_unique<BTSequence>(std::vector<std::shared_ptr <BTNode>>({ isr, lfs }));
-        tree->init(entity);
-    }
-
+    // Adding Behaviour Tree to Spider, shared by all of them
     auto& ai = ECS::registry<AI>.get(entity);
-    ai.tree = tree;
+    ai.tree = &BTDefinition::spider();
+    ai.instance = ai.tree->start(entity);
     return entity;
 }
 
@@ -143,7 +131,7 @@ ECS::Entity SuperSpider::createSuperSpider(vec2 position, ECS::Entity entity)
     return entity;
 }
 
-ECS::Entity SuperSpider::createSuperSpider(Motion motion, ECS::Entity entity, std::shared_ptr<BTNode> tree)
+ECS::Entity SuperSpider::createSuperSpider(Motion motion, ECS::Entity entity)
 {
     // Create rendering primitives
     std::string key = "superspider";
@@ -176,16 +164,9 @@ ECS::Entity SuperSpider::createSuperSpider(Motion motion, ECS::Entity entity, st
     auto& fire = ECS::registry<Fire>.emplace(entity);
     fire.fired = false;
 
-    // Adding Behaviour Tree to super spider
-    if (!tree)
-    {
-        std::shared_ptr <BTNode> lfs = std::make_unique<LookForSnail>(false);
-        std::shared_ptr <BTNode> isr = std::make_unique<IsSnailInRange>();
-        tree = std::make_unique<BTSequence>(std::vector<std::shared_ptr <BTNode>>({ isr, lfs }));
-        tree->init(entity);
-    }
-
+    // Adding Behaviour Tree to super spider, the same as the spider's
     auto& ai = ECS::registry<AI>.get(entity);
-    ai.tree = tree;
+    ai.tree = &BTDefinition::spider();
+    ai.instance = ai.tree->start(entity);
     return entity;
 }
@@ -1,17 +1,25 @@
 #include "tiles/tiles.hpp"
 
+// stlib
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
 float TileSystem::scale = 0.f;
 std::vector<std::vector<Tile>> TileSystem::tiles;
 ScrollDirection TileSystem::scrollDirection = LEFT_TO_RIGHT;
 static unsigned turns_for_camera_update = 1;
 static ivec2 endCoordinates = ivec2(-1,-1);
+static unsigned int gridVersion = 0;
 
 // Possible tile that entity can travel
 static TileSystem::vec2Map tileMovesMap;
+static std::vector<bool> tileMovesGrid;
+static ivec2 tileMovesGridSize = { 0, 0 };
 
 float TileSystem::getScale() { return scale; }
 void TileSystem::setScale(float s) { scale = s; }
-void TileSystem::resetGrid() { tiles.clear(); }
+void TileSystem::resetGrid() { tiles.clear(); gridChanged(); }
 unsigned TileSystem::getTurnsForCameraUpdate() { return turns_for_camera_update; }
 void TileSystem::setTurnsForCameraUpdate(unsigned turns) { turns_for_camera_update = turns; }
 ivec2 TileSystem::getEndCoordinates() { return endCoordinates; };
@@ -20,3 +28,138 @@ std::vector<std::vector<Tile>>& TileSystem::getTiles() { return tiles; }
 ScrollDirection TileSystem::getScrollDirection() { return scrollDirection; }
 void TileSystem::setScrollDirection(ScrollDirection dir) { scrollDirection = dir; }
 TileSystem::vec2Map& TileSystem::getAllTileMovesMap() { return tileMovesMap; }
+ivec2 TileSystem::getTileMovesGridSize() { return tileMovesGridSize; }
+unsigned int TileSystem::getGridVersion() { return gridVersion; }
+void TileSystem::gridChanged() { gridVersion++; }
+
+void Tile::addOccupyingEntity()
+{
+    numOccupyingEntities++;
+    TileSystem::gridChanged();
+    if (numOccupyingEntities == 1)
+    {
+        notify(Event(Event::TILE_OCCUPIED));
+    }
+}
+
+void Tile::removeOccupyingEntity()
+{
+    if (numOccupyingEntities == 0)
+    {
+        std::cout << "tried to remove an occupying entity when there were none" << "\n";
+        return;
+    }
+    numOccupyingEntities--;
+    TileSystem::gridChanged();
+    if (numOccupyingEntities == 0)
+    {
+        notify(Event(Event::TILE_UNOCCUPIED));
+    }
+}
+
+void TileSystem::rebuildTileMovesMap()
+{
+	tileMovesMap.clear();
+	int y = 0;
+	for (auto& rows : tiles) // Iterating over rows
+	{
+		int x = 0;
+		for (auto& elem : rows)
+		{
+			if (elem.type == WALL) {
+				if (y - 1 > 0 && (tiles[y - 1][x].type == VINE || tiles[y - 1][x].type == EMPTY)) {
+					auto& elem2 = tiles[y - 1][x];
+					tileMovesMap.insert({ {y - 1, x}, elem2 });
+				}
+				if (x - 1 > 0 && (tiles[y][x - 1].type == VINE || tiles[y][x - 1].type == EMPTY)) {
+					auto& elem2 = tiles[y][x - 1];
+					tileMovesMap.insert({ {y, x - 1}, elem2 });
+				}
+				if (y + 1 < static_cast<int>(tiles.size()) && (tiles[y + 1][x].type == VINE || tiles[y + 1][x].type == EMPTY)) {
+					auto& elem2 = tiles[y + 1][x];
+					tileMovesMap.insert({ {y + 1, x}, elem2 });
+				}
+				if (x + 1 < static_cast<int>(tiles[y].size()) && (tiles[y][x + 1].type == VINE || tiles[y][x + 1].type == EMPTY))
+				{
+					auto& elem2 = tiles[y][x + 1];
+					tileMovesMap.insert({ {y, x + 1}, elem2 });
+				}
+			}
+			else if (elem.type == VINE) {
+				tileMovesMap.insert({ {y, x}, elem });
+			}
+			x++;
+		}
+		y++;
+	}
+}
+
+void TileSystem::rebuildTileMovesGrid()
+{
+	int cols = 0;
+	for (auto& row : tiles)
+		cols = std::max(cols, static_cast<int>(row.size()));
+	tileMovesGridSize = { static_cast<int>(tiles.size()), cols };
+	tileMovesGrid.assign(tileMovesGridSize.x * tileMovesGridSize.y, false);
+	for (auto& move : tileMovesMap)
+	{
+		if (move.first.x >= 0 && move.first.x < tileMovesGridSize.x && move.first.y >= 0 && move.first.y < tileMovesGridSize.y)
+			tileMovesGrid[move.first.x * tileMovesGridSize.y + move.first.y] = true;
+	}
+}
+
+bool TileSystem::isMoveTile(int row, int col)
+{
+	if (row < 0 || row >= tileMovesGridSize.x || col < 0 || col >= tileMovesGridSize.y)
+		return false;
+	return tileMovesGrid[row * tileMovesGridSize.y + col];
+}
+
+bool TileSystem::isWall(int x, int y)
+{
+	if (y < 0 || y >= static_cast<int>(tiles.size()) || x < 0 || x >= static_cast<int>(tiles[y].size()))
+		return false;
+	return tiles[y][x].type == WALL;
+}
+
+bool TileSystem::raycastWall(vec2 origin, vec2 velocity, float maxTime, float& hitTime, vec2& normal)
+{
+	const float infinity = std::numeric_limits<float>::infinity();
+	int x = static_cast<int>(std::floor(origin.x / scale));
+	int y = static_cast<int>(std::floor(origin.y / scale));
+	int stepX = (velocity.x > 0) ? 1 : ((velocity.x < 0) ? -1 : 0);
+	int stepY = (velocity.y > 0) ? 1 : ((velocity.y < 0) ? -1 : 0);
+
+	// time until the next vertical/horizontal grid line is crossed, and the time between two of them
+	float nextX = (stepX > 0) ? ((x + 1) * scale - origin.x) / velocity.x : ((stepX < 0) ? (x * scale - origin.x) / velocity.x : infinity);
+	float nextY = (stepY > 0) ? ((y + 1) * scale - origin.y) / velocity.y : ((stepY < 0) ? (y * scale - origin.y) / velocity.y : infinity);
+	float deltaX = (stepX != 0) ? scale / std::abs(velocity.x) : infinity;
+	float deltaY = (stepY != 0) ? scale / std::abs(velocity.y) : infinity;
+
+	while (true)
+	{
+		float t;
+		if (nextX < nextY)
+		{
+			t = nextX;
+			x += stepX;
+			nextX += deltaX;
+			normal = vec2(-stepX, 0);
+		}
+		else
+		{
+			t = nextY;
+			y += stepY;
+			nextY += deltaY;
+			normal = vec2(0, -stepY);
+		}
+
+		if (t > maxTime || t == infinity)
+			return false;
+		if (isWall(x, y))
+		{
+			hitTime = t;
+			return true;
+		}
+	}
+}
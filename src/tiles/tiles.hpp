@@ -28,28 +28,8 @@ public:
         numOccupyingEntities = 0;
     }
 
-    void addOccupyingEntity() 
-    {
-        numOccupyingEntities++;
-        if (numOccupyingEntities == 1) 
-        {
-            notify(Event(Event::TILE_OCCUPIED));
-        }
-    }
-
-    void removeOccupyingEntity()
-    {
-        if (numOccupyingEntities == 0) 
-        {
-            std::cout << "tried to remove an occupying entity when there were none" << "\n";
-            return;
-        }
-        numOccupyingEntities--;
-        if (numOccupyingEntities == 0)
-        {
-            notify(Event(Event::TILE_UNOCCUPIED));
-        }
-    }
+    void addOccupyingEntity();
+    void removeOccupyingEntity();
 
     bool operator==(const Tile& rhs) const
     {
@@ -98,6 +78,25 @@ public:
 	static void setScrollDirection(ScrollDirection dir);
 
 	static vec2Map& getAllTileMovesMap();
+	// the tiles characters can crawl on, the open tiles next to a wall and the vines, once the tiles are placed
+	static void rebuildTileMovesMap();
+	// flat (row, column) copy of the moves map for the path finding, rebuild after changing the map
+	static void rebuildTileMovesGrid();
+	static bool isMoveTile(int row, int col);
+	// rows, columns
+	static ivec2 getTileMovesGridSize();
+
+	// changes with every change to the type or the occupants of a tile, for anything computed from the grid
+	static unsigned int getGridVersion();
+	static void gridChanged();
+
+	// whether the tile at grid coordinates (x, y) is a wall, false outside of the grid
+	static bool isWall(int x, int y);
+
+	// Walks the grid cells a point moving from origin with velocity passes through (Amanatides-Woo traversal) and finds the
+	// first wall it enters within maxTime. Gives the time it enters and the normal of the wall face it crosses.
+	// The cell the point starts in is not checked.
+	static bool raycastWall(vec2 origin, vec2 velocity, float maxTime, float& hitTime, vec2& normal);
 
 private:
 	static float scale;
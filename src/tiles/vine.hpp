@@ -11,5 +11,5 @@ public:
 	static ECS::Entity createVineTile(Tile& tile, ECS::Entity entity = ECS::Entity());
 	static ECS::Entity createVineTile(vec2 pos, ECS::Entity entity = ECS::Entity());
 	void onNotify(Event env);
-	ECS::Entity entity;
+	ECS::Entity entity = ECS::Entity::null();
 };
@@ -1,6 +1,8 @@
 // Header
 #include "water.hpp"
 #include "render.hpp"
+#include "crawl_graph.hpp"
+#include "visibility.hpp"
 
 ECS::Entity WaterTile::createWaterTile(Tile& tile, ECS::Entity entity)
 {
@@ -124,6 +126,9 @@ void WaterTile::onNotify(Event env, ECS::Entity& e)
             WaterTile::createWaterSplashTile(tile, entity);
             WaterTile::splashEntityID = entity.id;
             tiles[yPos][xPos] = tile;
+            CrawlGraph::tileChanged(yPos, xPos);
+            Visibility::tileChanged(yPos, xPos);
+            TileSystem::gridChanged();
         }
     }
 }
@@ -12,6 +12,6 @@ struct WaterTile
     static ECS::Entity createWaterSplashTile(Tile& tile, ECS::Entity entity = ECS::Entity());
     static ECS::Entity createWaterSplashTile(vec2 pos, ECS::Entity entity = ECS::Entity());
     static unsigned int splashEntityID;
-    ECS::Entity entity;
+    ECS::Entity entity = ECS::Entity::null();
     static void onNotify(Event env, ECS::Entity& e);
 };
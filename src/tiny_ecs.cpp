@@ -4,20 +4,105 @@
 #include <cassert>
 #include <iostream>
 #include <typeinfo>
+#include <algorithm>
 
-// We store a list of all Component containers to be able to inspect the number of components and entities in each and to remove entities across containers
 using namespace ECS;
 
+namespace {
+	// Per-slot generations and the list of released slots that can be handed out again
+	struct EntityAllocator
+	{
+		std::vector<unsigned int> generations = { 0 }; // slot 0 is reserved for the null entity
+		std::vector<unsigned int> free_slots;
+	};
+
+	EntityAllocator& entity_allocator() {
+		static EntityAllocator allocator; // Meyer's singleton, entities may be created during static initialization
+		return allocator;
+	}
+}
+
+unsigned int Entity::allocate_id() {
+	auto& allocator = entity_allocator();
+	unsigned int index;
+	if (!allocator.free_slots.empty())
+	{
+		index = allocator.free_slots.back();
+		allocator.free_slots.pop_back();
+	}
+	else
+	{
+		index = static_cast<unsigned int>(allocator.generations.size());
+		assert(index <= index_mask); // ran out of entity slots
+		allocator.generations.push_back(0);
+	}
+	return (allocator.generations[index] << index_bits) | index;
+}
+
+bool Entity::is_alive(Entity e) {
+	const auto& generations = entity_allocator().generations;
+	return !e.is_null() && e.index() < generations.size() && generations[e.index()] == e.generation();
+}
+
+Entity Entity::from_index(unsigned int index) {
+	const auto& generations = entity_allocator().generations;
+	assert(index > 0 && index < generations.size());
+	return Entity((generations[index] << index_bits) | index);
+}
+
+void Entity::release(Entity e) {
+	if (!is_alive(e))
+		return; // already released, don't hand out the slot twice
+	auto& allocator = entity_allocator();
+	auto& generation = allocator.generations[e.index()];
+	generation = (generation + 1) & generation_mask;
+	allocator.free_slots.push_back(e.index());
+}
+
+// We store a list of all Component containers to be able to inspect the number of components and entities in each and to remove entities across containers
 std::vector<ContainerInterface*>& ContainerInterface::registry_list_singleton() {
 	// This is a Meyer's singleton, i.e., a function returning a static local variable by reference to solve SIOF
 	static std::vector<ContainerInterface*> singleton; // constructed during first call
 	return singleton;
 }
 
+namespace {
+	// Component signatures indexed by entity slot
+	std::vector<Signature>& signatures_singleton() {
+		static std::vector<Signature> signatures;
+		return signatures;
+	}
+}
+
+const Signature& ContainerInterface::signature_of(Entity e) {
+	static const Signature empty;
+	const auto& signatures = signatures_singleton();
+	if (e.index() >= signatures.size() || !Entity::is_alive(e))
+		return empty;
+	return signatures[e.index()];
+}
+
+Signature& ContainerInterface::mutable_signature_of(Entity e) {
+	auto& signatures = signatures_singleton();
+	if (e.index() >= signatures.size())
+		signatures.resize(e.index() + 1);
+	return signatures[e.index()];
+}
+
 void ContainerInterface::clear_all_components() {
+	// every entity with a component is gone afterwards, like with remove_all_components_of
+	std::vector<Entity> cleared;
+	const auto& signatures = signatures_singleton();
+	for (unsigned int index = 1; index < signatures.size(); index++) {
+		if (signatures[index].any())
+			cleared.push_back(Entity::from_index(index));
+    }
 	for (auto reg : registry_list_singleton()) {
 		reg->clear();
     }
+	for (auto e : cleared) {
+		Entity::release(e);
+    }
 }
 void ContainerInterface::list_all_components() {
 	std::cout << "Debug info on all regestry entries:\n";
@@ -26,7 +111,7 @@ void ContainerInterface::list_all_components() {
         assert(reg); // Must not be null
 		if (reg->size() > 0) {
 			std::cout << reg->size() << " components of type" << typeid(*reg).name() << '\n';
-			for (auto entity : reg->entities) {
+			for (auto entity : reg->entity_list()) {
 				std::cout << entity.id << ", ";
             }
 			std::cout << '\n';
@@ -39,13 +124,77 @@ void ContainerInterface::list_all_components_of(Entity e) {
 	for (auto reg : registry_list_singleton()) {
         assert(reg); // Must not be null
 		if (reg->has(e)) {
-			std::cout << "type" << typeid(*reg).name() << ", stored at location " << reg->map_entity_component_index[e.id] << '\n';
+			std::cout << "type" << typeid(*reg).name() << ", stored at location " << reg->storage_index(e) << '\n';
         }
     }
 }
 void ContainerInterface::remove_all_components_of(Entity e) {
-	for (auto reg : registry_list_singleton()) {
-        assert(reg); // Must not be null
-		reg->remove(e);
+	if (!Entity::is_alive(e))
+		return; // stale handle, its components are already gone
+	// only visit the containers the entity is in, copied since removing clears the bits
+	const Signature signature = signature_of(e);
+	const auto& singleton = registry_list_singleton();
+	for (unsigned int type_id = 0; type_id < singleton.size(); type_id++) {
+		if (signature.test(type_id))
+			singleton[type_id]->remove(e);
+    }
+	Entity::release(e);
+}
+void ContainerInterface::remove_all_components_of(const std::vector<Entity>& batch) {
+	Signature signature;
+	for (auto e : batch) {
+		signature |= signature_of(e);
     }
+	const auto& singleton = registry_list_singleton();
+	for (unsigned int type_id = 0; type_id < singleton.size(); type_id++) {
+		if (signature.test(type_id))
+			singleton[type_id]->remove_batch(batch);
+    }
+	for (auto e : batch) {
+		Entity::release(e);
+    }
+}
+
+void CommandBuffer::destroy(Entity e) {
+	if (!Entity::is_alive(e) || is_pending_destroy(e))
+		return;
+	if (e.index() >= pending_destroy_ids.size())
+		pending_destroy_ids.resize(e.index() + 1, 0);
+	pending_destroy_ids[e.index()] = e.id;
+	pending_destroy.push_back(e);
+}
+
+bool CommandBuffer::is_pending_destroy(Entity e) const {
+	return !e.is_null() && e.index() < pending_destroy_ids.size() && pending_destroy_ids[e.index()] == e.id;
+}
+
+void CommandBuffer::flush() {
+	// Swap the queues out first, the operations may record new commands for the next flush
+	auto emplaces = std::move(pending_emplace);
+	auto removes = std::move(pending_remove);
+	auto destroys = std::move(pending_destroy);
+	pending_emplace.clear();
+	pending_remove.clear();
+	pending_destroy.clear();
+	for (Entity e : destroys)
+		pending_destroy_ids[e.index()] = 0;
+
+	for (auto& emplace : emplaces) {
+		emplace();
+    }
+	for (auto& remove : removes) {
+		remove.first->remove_batch(remove.second);
+    }
+	if (!destroys.empty()) {
+		ContainerInterface::remove_all_components_of(destroys);
+    }
+}
+
+bool CommandBuffer::empty() const {
+	return pending_emplace.empty() && pending_remove.empty() && pending_destroy.empty();
+}
+
+CommandBuffer& ECS::commands() {
+	static CommandBuffer buffer; // Meyer's singleton, see registry_list_singleton
+	return buffer;
 }
@@ -1,8 +1,16 @@
 #pragma once
 
 #include <vector>
-#include <unordered_map>
+#include <memory>
 #include <algorithm>
+#include <iterator>
+#include <functional>
+#include <bitset>
+#include <cstdint>
+#include <type_traits>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 #include <assert.h>
 
 namespace ECS {
@@ -11,67 +19,150 @@ namespace ECS {
 	{
 		Entity()
 		{
-			id = next_id();
-			// Note, indices of already deleted entities arent re-used in this simple implementation.
+			id = allocate_id();
+			// Note, indices of deleted entities are re-used, with a bumped generation to tell old handles apart.
 		}
 
-		// The ID defines an entity
+		// The null entity does not allocate an id and is never alive, use it for placeholder members
+		static Entity null()
+		{
+			return Entity(0u);
+		}
+
+		// The ID defines an entity, the low bits are the slot index and the high bits its generation
 		unsigned int id;
+
+		unsigned int index() const { return id & index_mask; }
+		unsigned int generation() const { return id >> index_bits; }
+		bool is_null() const { return id == 0; }
+
+		// Whether the handle still refers to a live entity, i.e. its slot was not released since
+		static bool is_alive(Entity e);
+		// Hands the slot back to the allocator, all existing handles to it become stale
+		static void release(Entity e);
+		// The current handle of an allocated slot
+		static Entity from_index(unsigned int index);
+
+		static const unsigned int index_bits = 20;
+		static const unsigned int index_mask = (1u << index_bits) - 1;
+		static const unsigned int generation_mask = (1u << (32 - index_bits)) - 1;
 	private:
-		
-		// yields ids from 1; entity 0 is the default initialization
-		static unsigned int next_id() {
-			static unsigned int id_count = 1;
-			return id_count++;
+		explicit Entity(unsigned int raw_id) : id(raw_id) {}
+
+		// yields ids from 1 (re-using released slots first); entity 0 is the null entity
+		static unsigned int allocate_id();
+	};
+
+	// Paged sparse array from entity slot index -> array index, replaces a hash map for O(1) lookups without hashing.
+	// Pages are only allocated for id ranges that are actually used, so sparse ids don't cost a full array.
+	class SparseIndex
+	{
+	public:
+		// Returns the array index stored for an id, or npos if there is none
+		unsigned int find(unsigned int id) const
+		{
+			unsigned int page = id >> page_bits;
+			if (page >= pages.size() || !pages[page])
+				return npos;
+			return pages[page][id & page_mask] - 1; // slots store index + 1 so that 0 means empty
+		}
+
+		void set(unsigned int id, unsigned int index)
+		{
+			unsigned int page = id >> page_bits;
+			if (page >= pages.size())
+				pages.resize(page + 1);
+			if (!pages[page])
+				pages[page].reset(new unsigned int[page_size]()); // value-initialized, i.e. all empty
+			pages[page][id & page_mask] = index + 1;
+		}
+
+		void erase(unsigned int id)
+		{
+			unsigned int page = id >> page_bits;
+			if (page < pages.size() && pages[page])
+				pages[page][id & page_mask] = 0;
+		}
+
+		void clear()
+		{
+			pages.clear();
 		}
+
+		static const unsigned int npos = ~0u;
+	private:
+		static const unsigned int page_bits = 10;
+		static const unsigned int page_size = 1u << page_bits;
+		static const unsigned int page_mask = page_size - 1;
+		std::vector<std::unique_ptr<unsigned int[]>> pages;
 	};
 
+	// One bit per registered component type, set for every component an entity has
+	static const unsigned int max_component_types = 128;
+	using Signature = std::bitset<max_component_types>;
+
 	// Common interface to refer to all containers in the ECS registry
 	struct ContainerInterface
 	{
 		virtual void clear() = 0;
 		virtual size_t size() = 0;
 		virtual void remove(Entity e) = 0;
+		virtual void remove_batch(const std::vector<Entity>& batch) = 0;
 		virtual bool has(Entity entity) = 0;
+		// Copy of the entities in the container and where an entity's component is stored, for debugging
+		virtual std::vector<Entity> entity_list() = 0;
+		virtual unsigned int storage_index(Entity e) = 0;
 
-		// The entities associated to the components in the container
-		std::vector<Entity> entities;
+		// The bit of this component type in entity signatures, i.e. its position in the registry list
+		unsigned int type_id = 0;
+
+		// The component types the entity currently has (empty for null or stale handles)
+		static const Signature& signature_of(Entity e);
 
 		// Callbacks to remove a particular or all entities in the system
 		static void clear_all_components();
 		static void list_all_components();
 		static void remove_all_components_of(Entity e);
+		static void remove_all_components_of(const std::vector<Entity>& batch);
 		static void list_all_components_of(Entity e);
 	protected:
-		// The hash map from Entity -> array index.
-		std::unordered_map<unsigned int, unsigned int> map_entity_component_index; // the entity is cast to uint to be hashable.
+		// Constructor that registers the component type
+		ContainerInterface()
+		{
+			auto& singleton = registry_list_singleton();
+			type_id = static_cast<unsigned int>(singleton.size());
+			assert(type_id < max_component_types); // increase max_component_types
+			singleton.push_back(this);
+		}
+
 		static std::vector<ContainerInterface*>& registry_list_singleton();
+		static Signature& mutable_signature_of(Entity e);
 	};
 
-	// A container that stores components of type 'Component' and associated entities
-	template <typename Component> // A component can be any class
+	// A container that stores components of type 'Component' and associated entities.
+	// Empty (tag) components are detected at compile time and stored as a bitset instead, see the specialization below.
+	template <typename Component, bool IsTag = std::is_empty<Component>::value> // A component can be any class
 	class ComponentContainer : public ContainerInterface
 	{
 	public:
 		// Container of all components of type 'Component'
 		std::vector<Component> components;
 
-		// Constructor that registers the component type
-		ComponentContainer()
-		{
-			auto& singleton = registry_list_singleton();
-			singleton.push_back(this);
-		}
+		// The entities associated to the components in the container
+		std::vector<Entity> entities;
 
 		// Inserting a component c associated to entity e
 		inline Component& insert(Entity e, Component&& c, bool check_for_duplicates = true)
 		{
 			// Usually, every entity should only have one instance of each component type
 			if (check_for_duplicates)
-				assert(map_entity_component_index.find(e.id) == map_entity_component_index.end());
+				assert(!has(e));
+
+			assert(Entity::is_alive(e));
 
 			auto component_index = static_cast<unsigned int>(components.size());
-			map_entity_component_index[e.id] = component_index; // Note, not using insert or emplace to allow inserting multiple components for the same entity (at your own risk)
+			entity_component_index.set(e.index(), component_index); // Note, overwrites the index to allow inserting multiple components for the same entity (at your own risk)
+			mutable_signature_of(e).set(type_id);
 			components.push_back(std::move(c)); // the move enforces move instead of copy constructor
 			entities.push_back(e);
 			return components.back();
@@ -89,56 +180,114 @@ namespace ECS {
 
 		// A wrapper to return the component of an entity
 		Component& get(Entity e) {
-			const auto it = map_entity_component_index.find(e.id);
-			assert(it != map_entity_component_index.end());
-			return components[it->second]; //it->first is the key, it->second the value
+			const auto index = find(e);
+			assert(index != SparseIndex::npos);
+			return components[index];
 		}
 
 		// Check if entity has a component of type 'Component'
 		bool has(Entity e) override  {
-			return map_entity_component_index.find(e.id) != map_entity_component_index.end();
+			return find(e) != SparseIndex::npos;
 		}
 
 		// Remove an component and pack the container to re-use the empty space
 		void remove(Entity e) override
 		{
 			// Get the current position
-			const auto it = map_entity_component_index.find(e.id);
-			if (it == map_entity_component_index.end())
+			const auto array_index = find(e);
+			if (array_index == SparseIndex::npos)
 				return; // no component stored for this element, nothing to do
 
-			int array_index = it->second;
 			// Move the last element to position cID using the move operator
 			// Note, components[cID] = components.back() would trigger the copy instead of move operator
 			components[array_index] = std::move(components.back());
 			entities[array_index] = entities.back(); // the entity is only a single index, copy it.
-			map_entity_component_index[entities.back().id] = array_index;
+			entity_component_index.set(entities.back().index(), array_index);
 
 			// Erase the old component and free its memory
-			map_entity_component_index.erase(it);
+			entity_component_index.erase(e.index());
+			mutable_signature_of(e).reset(type_id);
 			components.pop_back();
 			entities.pop_back();
+
+			// the moved element breaks the sorted order from array_index on
+			sorted_prefix = std::min<size_t>(sorted_prefix, std::min<size_t>(array_index, entities.size()));
 		};
 
+		// Remove the components of several entities at once, compacting the container in a single pass.
+		// Unlike remove, this keeps the order of the remaining components (e.g. a sorted render order).
+		void remove_batch(const std::vector<Entity>& batch) override
+		{
+			bool removed_any = false;
+			for (auto e : batch)
+			{
+				const auto array_index = find(e);
+				if (array_index == SparseIndex::npos)
+					continue;
+				entity_component_index.erase(e.index());
+				mutable_signature_of(e).reset(type_id);
+				entities[array_index] = Entity::null(); // marks the slot for compaction
+				removed_any = true;
+			}
+			if (!removed_any)
+				return;
+
+			unsigned int write = 0;
+			size_t kept_sorted = 0;
+			for (unsigned int read = 0; read < entities.size(); read++)
+			{
+				if (entities[read].is_null())
+					continue;
+				if (read < sorted_prefix)
+					kept_sorted++;
+				if (write != read)
+				{
+					components[write] = std::move(components[read]);
+					entities[write] = entities[read];
+					entity_component_index.set(entities[write].index(), write);
+				}
+				write++;
+			}
+			components.erase(components.begin() + write, components.end());
+			entities.erase(entities.begin() + write, entities.end());
+			sorted_prefix = kept_sorted;
+		}
+
 		// Sort the components and associated entity assignment structures by the comparisonFunction that compares the order of two entities
 		template <class Compare>
 		void sort(Compare comparisonFunction)
 		{
-			// First sort the entity list as desired
-			std::sort(entities.begin(), entities.end(), comparisonFunction);
-			// Now re-arrange the components (Note, creates a temporary vector, which may be slow! Not sure if in-place could be faster: https://stackoverflow.com/questions/63703637/how-to-efficiently-permute-an-array-in-place-using-stdswap)
-			std::vector<Component> components_new; components_new.reserve(components.size());
-			std::transform(entities.begin(), entities.end(), std::back_inserter(components_new), [&](Entity e) { return std::move(get(e)); }); // note, the get still uses the old hash map (on purpose!)
-			components = std::move(components_new); // Note, we use move operations to not create unneccesary copies of objects, but memory is still allocated for the new vector
-			// Fill the new hashmap
-			for (unsigned int i = 0; i < entities.size(); i++)
-				map_entity_component_index[entities[i].id] = i;
+			// First sort a copy of the entity list as desired, the comparison may still look up components through the container
+			std::vector<Entity> order = entities;
+			std::stable_sort(order.begin(), order.end(), comparisonFunction);
+			reorder(order);
+		}
+
+		// Like sort, but only sorts what changed since the last sort: components inserted since are sorted and merged into the
+		// already sorted ones, and nothing is done at all if no component was added or swap-removed (remove_batch keeps the order).
+		// Only valid if the same comparison is used every time and the compared data of existing components doesn't change.
+		// Returns whether any reordering work was done.
+		template <class Compare>
+		bool sort_incremental(Compare comparisonFunction)
+		{
+			if (sorted_prefix == entities.size())
+				return false;
+
+			std::vector<Entity> tail(entities.begin() + sorted_prefix, entities.end());
+			std::stable_sort(tail.begin(), tail.end(), comparisonFunction);
+			std::vector<Entity> order; order.reserve(entities.size());
+			std::merge(entities.begin(), entities.begin() + sorted_prefix, tail.begin(), tail.end(), std::back_inserter(order), comparisonFunction);
+			reorder(order);
+			return true;
 		}
 
 		// Remove all components of type 'Component'
 		void clear() override
 		{
-			map_entity_component_index.clear();
+			for (auto e : entities)
+				mutable_signature_of(e).reset(type_id);
+			entity_component_index.clear();
+			sorted_prefix = 0;
 			components.clear();
 			entities.clear();
 		}
@@ -148,9 +297,497 @@ namespace ECS {
 		{
 			return components.size();
 		}
+
+		// Calls f(entity, component) for all entities, iterating backwards so that f may remove the current entity or add new ones (which are not visited)
+		template <typename Function>
+		void visit_components(Function f)
+		{
+			for (size_t i = components.size(); i-- > 0;)
+			{
+				if (i >= components.size())
+					continue; // f removed more than the current entity
+				f(entities[i], components[i]);
+			}
+		}
+
+		// Calls f(entity, component) for all entities in container order, f must not add or remove components of this type
+		template <typename Function>
+		void visit_components_in_order(Function f)
+		{
+			for (size_t i = 0; i < components.size(); i++)
+				f(entities[i], components[i]);
+		}
+
+		std::vector<Entity> entity_list() override
+		{
+			return entities;
+		}
+
+		unsigned int storage_index(Entity e) override
+		{
+			return find(e);
+		}
+
+	private:
+		// The sparse set index from Entity -> array index, entities[i] is the reverse mapping.
+		SparseIndex entity_component_index;
+
+		// The first sorted_prefix entities are in the order of the last sort, the rest was inserted since
+		size_t sorted_prefix = 0;
+
+		// Re-arrange the components and entities into the given order (a permutation of entities)
+		void reorder(const std::vector<Entity>& order)
+		{
+			// Note, creates a temporary vector, which may be slow! Not sure if in-place could be faster: https://stackoverflow.com/questions/63703637/how-to-efficiently-permute-an-array-in-place-using-stdswap
+			std::vector<Component> components_new; components_new.reserve(components.size());
+			std::transform(order.begin(), order.end(), std::back_inserter(components_new), [&](Entity e) { return std::move(components[entity_component_index.find(e.index())]); }); // note, this still uses the old index (on purpose!)
+			components = std::move(components_new); // Note, we use move operations to not create unneccesary copies of objects, but memory is still allocated for the new vector
+			entities = order;
+			// Fill the new index
+			for (unsigned int i = 0; i < entities.size(); i++)
+				entity_component_index.set(entities[i].index(), i);
+			sorted_prefix = entities.size();
+		}
+
+		// Array index of the entity's component, stale handles whose slot was re-used don't match
+		unsigned int find(Entity e) const
+		{
+			const auto index = entity_component_index.find(e.index());
+			if (index == SparseIndex::npos || entities[index].id != e.id)
+				return SparseIndex::npos;
+			return index;
+		}
+	};
+
+	// Index of the lowest/highest set bit of a non-zero word
+	inline unsigned int lowest_bit(uint64_t word)
+	{
+#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanForward64(&index, word);
+		return static_cast<unsigned int>(index);
+#else
+		return static_cast<unsigned int>(__builtin_ctzll(word));
+#endif
+	}
+	inline unsigned int highest_bit(uint64_t word)
+	{
+#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanReverse64(&index, word);
+		return static_cast<unsigned int>(index);
+#else
+		return 63u - static_cast<unsigned int>(__builtin_clzll(word));
+#endif
+	}
+
+	// A set of entities stored as one bit per entity slot, iterated by scanning for set bits (in slot order)
+	class EntityBitset
+	{
+	public:
+		class iterator
+		{
+		public:
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = Entity;
+			using difference_type = std::ptrdiff_t;
+			using pointer = const Entity*;
+			using reference = Entity;
+
+			iterator(const std::vector<uint64_t>* words, size_t slot) : words(words), slot(slot) { skip_to_set_bit(); }
+			Entity operator*() const { return Entity::from_index(static_cast<unsigned int>(slot)); }
+			iterator& operator++() { slot++; skip_to_set_bit(); return *this; }
+			iterator operator++(int) { iterator old = *this; ++(*this); return old; }
+			bool operator==(const iterator& other) const { return slot == other.slot; }
+			bool operator!=(const iterator& other) const { return slot != other.slot; }
+		private:
+			// Advances to the next set bit at or after slot, or to the end
+			void skip_to_set_bit()
+			{
+				size_t word = slot / 64;
+				if (word >= words->size())
+				{
+					slot = words->size() * 64;
+					return;
+				}
+				uint64_t bits = (*words)[word] & (~uint64_t(0) << (slot % 64));
+				while (bits == 0)
+				{
+					if (++word == words->size())
+					{
+						slot = words->size() * 64;
+						return;
+					}
+					bits = (*words)[word];
+				}
+				slot = word * 64 + lowest_bit(bits);
+			}
+			const std::vector<uint64_t>* words;
+			size_t slot;
+		};
+
+		iterator begin() const { return iterator(&words, 0); }
+		iterator end() const { return iterator(&words, words.size() * 64); }
+		size_t size() const { return count; }
+		bool empty() const { return count == 0; }
+
+		// The i-th entity in slot order, note that this is a linear scan
+		Entity operator[](size_t i) const
+		{
+			assert(i < count);
+			auto it = begin();
+			while (i-- > 0)
+				++it;
+			return *it;
+		}
+
+		Entity back() const
+		{
+			assert(count > 0);
+			for (size_t word = words.size(); word-- > 0;)
+			{
+				if (words[word] != 0)
+					return Entity::from_index(static_cast<unsigned int>(word * 64 + highest_bit(words[word])));
+			}
+			assert(false);
+			return Entity::null();
+		}
+
+		bool test(unsigned int slot) const
+		{
+			return slot / 64 < words.size() && (words[slot / 64] >> (slot % 64)) & 1u;
+		}
+
+		// Returns whether the bit changed
+		bool set(unsigned int slot)
+		{
+			if (slot / 64 >= words.size())
+				words.resize(slot / 64 + 1, 0);
+			if (test(slot))
+				return false;
+			words[slot / 64] |= uint64_t(1) << (slot % 64);
+			count++;
+			return true;
+		}
+
+		bool reset(unsigned int slot)
+		{
+			if (!test(slot))
+				return false;
+			words[slot / 64] &= ~(uint64_t(1) << (slot % 64));
+			count--;
+			return true;
+		}
+
+		void clear()
+		{
+			words.clear();
+			count = 0;
+		}
+
+		// The raw bit words, e.g. to iterate over a snapshot
+		const std::vector<uint64_t>& bits() const { return words; }
+	private:
+		std::vector<uint64_t> words;
+		size_t count = 0;
+	};
+
+	// Storage for empty tag components (e.g. Player, Enemy, Overlay): a bitset over entity slots, no per-entity component objects.
+	// All entities share a single instance of the (stateless) component.
+	template <typename Component>
+	class ComponentContainer<Component, true> : public ContainerInterface
+	{
+	public:
+		// The entities that have the tag, in slot order (not insertion order)
+		EntityBitset entities;
+
+		inline Component& insert(Entity e, Component&&, bool check_for_duplicates = true)
+		{
+			if (check_for_duplicates)
+				assert(!has(e));
+			assert(Entity::is_alive(e));
+
+			entities.set(e.index());
+			mutable_signature_of(e).set(type_id);
+			return instance;
+		}
+
+		template<typename... Args>
+		Component& emplace(Entity e, Args &&... args) {
+			return insert(e, Component(std::forward<Args>(args)...));
+		};
+		template<typename... Args>
+		Component& emplace_with_duplicates(Entity e, Args &&... args) {
+			return insert(e, Component(std::forward<Args>(args)...), false);
+		};
+
+		Component& get(Entity e) {
+			assert(has(e));
+			(void)e;
+			return instance;
+		}
+
+		bool has(Entity e) override {
+			return entities.test(e.index()) && Entity::is_alive(e);
+		}
+
+		void remove(Entity e) override
+		{
+			if (!has(e))
+				return;
+			entities.reset(e.index());
+			mutable_signature_of(e).reset(type_id);
+		}
+
+		void remove_batch(const std::vector<Entity>& batch) override
+		{
+			for (auto e : batch)
+				remove(e);
+		}
+
+		void clear() override
+		{
+			for (auto e : entities)
+				mutable_signature_of(e).reset(type_id);
+			entities.clear();
+		}
+
+		size_t size() override
+		{
+			return entities.size();
+		}
+
+		// Calls f(entity, component) for all entities, iterating a snapshot so that f may remove entities or add new ones (which are not visited)
+		template <typename Function>
+		void visit_components(Function f)
+		{
+			const std::vector<uint64_t> snapshot = entities.bits();
+			for (size_t word = snapshot.size(); word-- > 0;)
+			{
+				uint64_t bits = snapshot[word];
+				while (bits != 0)
+				{
+					unsigned int bit = highest_bit(bits);
+					bits &= ~(uint64_t(1) << bit);
+					unsigned int slot = static_cast<unsigned int>(word * 64 + bit);
+					if (entities.test(slot)) // not removed by f in the meantime
+						f(Entity::from_index(slot), instance);
+				}
+			}
+		}
+
+		// Calls f(entity, component) for all entities in slot order
+		template <typename Function>
+		void visit_components_in_order(Function f)
+		{
+			for (auto e : entities)
+				f(e, instance);
+		}
+
+		std::vector<Entity> entity_list() override
+		{
+			return std::vector<Entity>(entities.begin(), entities.end());
+		}
+
+		unsigned int storage_index(Entity e) override
+		{
+			return e.index();
+		}
+
+	private:
+		static Component instance;
 	};
 
+	template <typename Component>
+	Component ComponentContainer<Component, true>::instance;
+
 	// Instanciate one component container for each desired class
 	template<class Component> // this is a variable template (c++14) that is created once per class and ECS instance https://en.cppreference.com/w/cpp/language/variable_template
 	ComponentContainer<Component> registry;
+
+	// Signature with the bits of all listed component types, e.g. mask<Spider, Slug>()
+	template <typename... Components>
+	Signature mask()
+	{
+		Signature result;
+		using expand = int[];
+		(void)expand{ 0, (result.set(registry<Components>.type_id), 0)... };
+		return result;
+	}
+
+	// Whether the entity has all components in the mask
+	inline bool matches(Entity e, const Signature& mask)
+	{
+		return (ContainerInterface::signature_of(e) & mask) == mask;
+	}
+
+	// Whether the entity has at least one of the components in the mask
+	inline bool matches_any(Entity e, const Signature& mask)
+	{
+		return (ContainerInterface::signature_of(e) & mask).any();
+	}
+
+	// Records structural changes (create/emplace/remove/destroy) and applies them in one batch on flush.
+	// Use it while iterating containers, instead of modifying them in place.
+	class CommandBuffer
+	{
+	public:
+		// The entity id is handed out immediately, its components are only added on flush
+		Entity create()
+		{
+			return Entity();
+		}
+
+		template <typename Component, typename... Args>
+		void emplace(Entity e, Args&&... args)
+		{
+			// construct now, so that the arguments don't need to outlive the call
+			Component c(std::forward<Args>(args)...);
+			pending_emplace.push_back([e, c]() mutable {
+				if (Entity::is_alive(e)) // destroyed before the flush
+					registry<Component>.insert(e, std::move(c));
+			});
+		}
+
+		template <typename Component>
+		void remove(Entity e)
+		{
+			ContainerInterface* container = &registry<Component>;
+			auto it = std::find_if(pending_remove.begin(), pending_remove.end(),
+				[container](const std::pair<ContainerInterface*, std::vector<Entity>>& entry) { return entry.first == container; });
+			if (it == pending_remove.end())
+			{
+				pending_remove.emplace_back(container, std::vector<Entity>());
+				it = pending_remove.end() - 1;
+			}
+			it->second.push_back(e);
+		}
+
+		// Removes all components of the entity and releases its id on flush
+		void destroy(Entity e);
+		// Whether destroy was recorded for the entity since the last flush
+		bool is_pending_destroy(Entity e) const;
+
+		// Applies all recorded changes: emplaces first, then removals grouped per container, then destroys
+		void flush();
+		bool empty() const;
+
+	private:
+		std::vector<std::function<void()>> pending_emplace;
+		std::vector<std::pair<ContainerInterface*, std::vector<Entity>>> pending_remove;
+		std::vector<Entity> pending_destroy;
+		// the id recorded in pending_destroy per slot index (0 if none), so checking for one doesn't search the list
+		std::vector<unsigned int> pending_destroy_ids;
+	};
+
+	// The frame's command buffer, flushed by the main loop after each system step
+	CommandBuffer& commands();
+
+	// Marks a component type that entities in a view must not have, e.g. view<Motion, Not<Overlay>>
+	template <typename Component>
+	struct Not {};
+
+	template <typename... Types>
+	struct TypeList {};
+
+	// Splits the view arguments into the included and the excluded (Not<...>) component types
+	template <typename Include, typename Exclude, typename... Rest>
+	struct SplitView;
+	template <typename... Include, typename... Exclude>
+	struct SplitView<TypeList<Include...>, TypeList<Exclude...>>
+	{
+		using include = TypeList<Include...>;
+		using exclude = TypeList<Exclude...>;
+	};
+	template <typename... Include, typename... Exclude, typename Component, typename... Rest>
+	struct SplitView<TypeList<Include...>, TypeList<Exclude...>, Component, Rest...> : SplitView<TypeList<Include..., Component>, TypeList<Exclude...>, Rest...> {};
+	template <typename... Include, typename... Exclude, typename Component, typename... Rest>
+	struct SplitView<TypeList<Include...>, TypeList<Exclude...>, Not<Component>, Rest...> : SplitView<TypeList<Include...>, TypeList<Exclude..., Component>, Rest...> {};
+
+	// Whether the entity has all of the listed components but Known (which it is known to have) / any of them,
+	// stopping at the first one that decides it
+	template <typename Known>
+	bool has_all_but(Entity, TypeList<>) { return true; }
+	template <typename Known, typename Component, typename... Rest>
+	bool has_all_but(Entity e, TypeList<Component, Rest...>)
+	{
+		return (std::is_same<Known, Component>::value || registry<Component>.has(e)) && has_all_but<Known>(e, TypeList<Rest...>());
+	}
+	inline bool has_any(Entity, TypeList<>) { return false; }
+	template <typename Component, typename... Rest>
+	bool has_any(Entity e, TypeList<Component, Rest...>)
+	{
+		return registry<Component>.has(e) || has_any(e, TypeList<Rest...>());
+	}
+
+	template <typename Include, typename Exclude>
+	class View;
+
+	// Iterates all entities that have every included component and none of the excluded ones.
+	// The callback receives the entity followed by a reference to each included component, in the order they are listed.
+	template <typename... Include, typename... Exclude>
+	class View<TypeList<Include...>, TypeList<Exclude...>>
+	{
+		static_assert(sizeof...(Include) > 0, "A view needs at least one included component type");
+	public:
+		// Check if the entity is part of the view, asks the containers since their lookups inline (signature_of doesn't)
+		static bool contains(Entity e)
+		{
+			return has_all_but<void>(e, TypeList<Include...>()) && !has_any(e, TypeList<Exclude...>());
+		}
+
+		// Visits the matches driven by the smallest included container, in no particular order.
+		// Iterates backwards, so the callback may remove the current entity or create new ones (which are not visited).
+		template <typename Function>
+		void each(Function f) const
+		{
+			using DrivenBy = void (*)(Function&);
+			const DrivenBy driven_by[] = { &View::each_driven_by<Include, Function>... };
+			const size_t sizes[] = { registry<Include>.size()... };
+			driven_by[std::min_element(std::begin(sizes), std::end(sizes)) - std::begin(sizes)](f);
+		}
+
+		// Visits the matches in the order of the 'Component' container, e.g. ShadedMeshRef after sorting by render order.
+		// The callback must not add or remove 'Component's.
+		template <typename Component, typename Function>
+		void each_in_order_of(Function f) const
+		{
+			registry<Component>.visit_components_in_order([&](Entity e, Component& driver) { visit(e, driver, f); });
+		}
+
+	private:
+		template <typename Driver, typename Function>
+		static void each_driven_by(Function& f)
+		{
+			registry<Driver>.visit_components([&](Entity e, Driver& driver) { visit(e, driver, f); });
+		}
+
+		// the driving container already handed over its component, the others are looked up
+		template <typename Driver, typename Function>
+		static void visit(Entity e, Driver& driver, Function& f)
+		{
+			if (has_all_but<Driver>(e, TypeList<Include...>()) && !has_any(e, TypeList<Exclude...>()))
+				f(e, component<Include>(e, driver, std::is_same<Include, Driver>())...);
+		}
+
+		template <typename Component, typename Driver>
+		static Component& component(Entity e, Driver&, std::false_type)
+		{
+			return registry<Component>.get(e);
+		}
+
+		template <typename Component>
+		static Component& component(Entity, Component& driver, std::true_type)
+		{
+			return driver;
+		}
+	};
+
+	// View over all entities with the listed components, wrap types in Not<...> to exclude them.
+	// E.g. view<ShadedMeshRef, Motion, Not<Overlay>>().each([](Entity e, ShadedMeshRef& mesh, Motion& motion) { ... });
+	template <typename... Components>
+	View<typename SplitView<TypeList<>, TypeList<>, Components...>::include, typename SplitView<TypeList<>, TypeList<>, Components...>::exclude> view()
+	{
+		return {};
+	}
 }
@@ -0,0 +1,148 @@
+// header
+#include "visibility.hpp"
+#include "tiles/tiles.hpp"
+
+// stlib
+#include <algorithm>
+#include <cstdlib>
+
+int Visibility::rowCount = 0;
+int Visibility::columnCount = 0;
+std::vector<bool> Visibility::walls;
+std::vector<uint16_t> Visibility::clearLeft;
+std::vector<uint16_t> Visibility::clearRight;
+std::vector<uint16_t> Visibility::clearUp;
+std::vector<uint16_t> Visibility::clearDown;
+std::vector<int> Visibility::wallCounts;
+
+int Visibility::index(int row, int col)
+{
+	return row * columnCount + col;
+}
+
+void Visibility::build()
+{
+	auto& tiles = TileSystem::getTiles();
+	rowCount = static_cast<int>(tiles.size());
+	columnCount = 0;
+	for (auto& row : tiles)
+		columnCount = std::max(columnCount, static_cast<int>(row.size()));
+
+	int size = rowCount * columnCount;
+	walls.assign(size, false);
+	clearLeft.assign(size, 0);
+	clearRight.assign(size, 0);
+	clearUp.assign(size, 0);
+	clearDown.assign(size, 0);
+	for (int row = 0; row < rowCount; row++)
+	{
+		for (int col = 0; col < static_cast<int>(tiles[row].size()); col++)
+			walls[index(row, col)] = tiles[row][col].type == WALL;
+	}
+	for (int row = 0; row < rowCount; row++)
+		updateRow(row);
+	for (int col = 0; col < columnCount; col++)
+		updateColumn(col);
+	updateWallCounts();
+}
+
+void Visibility::tileChanged(int row, int col)
+{
+	auto& tiles = TileSystem::getTiles();
+	if (row < 0 || row >= rowCount || col < 0 || col >= static_cast<int>(tiles[row].size()))
+		return;
+	bool wall = tiles[row][col].type == WALL;
+	// only walls block the view
+	if (walls[index(row, col)] == wall)
+		return;
+	walls[index(row, col)] = wall;
+	updateRow(row);
+	updateColumn(col);
+	updateWallCounts();
+}
+
+void Visibility::updateRow(int row)
+{
+	uint16_t clear = 0;
+	for (int col = 0; col < columnCount; col++)
+	{
+		clearLeft[index(row, col)] = clear;
+		clear = walls[index(row, col)] ? 0 : clear + 1;
+	}
+	clear = 0;
+	for (int col = columnCount - 1; col >= 0; col--)
+	{
+		clearRight[index(row, col)] = clear;
+		clear = walls[index(row, col)] ? 0 : clear + 1;
+	}
+}
+
+void Visibility::updateColumn(int col)
+{
+	uint16_t clear = 0;
+	for (int row = 0; row < rowCount; row++)
+	{
+		clearUp[index(row, col)] = clear;
+		clear = walls[index(row, col)] ? 0 : clear + 1;
+	}
+	clear = 0;
+	for (int row = rowCount - 1; row >= 0; row--)
+	{
+		clearDown[index(row, col)] = clear;
+		clear = walls[index(row, col)] ? 0 : clear + 1;
+	}
+}
+
+void Visibility::updateWallCounts()
+{
+	int stride = columnCount + 1;
+	wallCounts.assign((rowCount + 1) * stride, 0);
+	for (int row = 0; row < rowCount; row++)
+	{
+		for (int col = 0; col < columnCount; col++)
+		{
+			wallCounts[(row + 1) * stride + col + 1] = (walls[index(row, col)] ? 1 : 0)
+				+ wallCounts[row * stride + col + 1] + wallCounts[(row + 1) * stride + col] - wallCounts[row * stride + col];
+		}
+	}
+}
+
+int Visibility::wallsBetween(ivec2 from, ivec2 to)
+{
+	int stride = columnCount + 1;
+	int top = std::min(from.x, to.x);
+	int bottom = std::max(from.x, to.x) + 1;
+	int left = std::min(from.y, to.y);
+	int right = std::max(from.y, to.y) + 1;
+	return wallCounts[bottom * stride + right] - wallCounts[top * stride + right]
+		- wallCounts[bottom * stride + left] + wallCounts[top * stride + left];
+}
+
+bool Visibility::inRange(ivec2 from, ivec2 to, int range)
+{
+	return abs(from.x - to.x) <= range && abs(from.y - to.y) <= range;
+}
+
+bool Visibility::canSee(ivec2 from, ivec2 to)
+{
+	if (from.x < 0 || from.x >= rowCount || from.y < 0 || from.y >= columnCount
+		|| to.x < 0 || to.x >= rowCount || to.y < 0 || to.y >= columnCount)
+		return false;
+
+	// along a row or a column, as far as the view goes that way
+	if (from.x == to.x)
+		return to.y > from.y ? to.y - from.y <= clearRight[index(from.x, from.y)] : from.y - to.y <= clearLeft[index(from.x, from.y)];
+	if (from.y == to.y)
+		return to.x > from.x ? to.x - from.x <= clearDown[index(from.x, from.y)] : from.x - to.x <= clearUp[index(from.x, from.y)];
+
+	// nothing in the way if there are no walls in the rectangle between them at all,
+	// otherwise follow the line through the grid like the projectiles do
+	if (wallsBetween(from, to) == 0)
+		return true;
+	float scale = TileSystem::getScale();
+	vec2 origin = { (from.y + 0.5f) * scale, (from.x + 0.5f) * scale };
+	vec2 direction = { (to.y - from.y) * scale, (to.x - from.x) * scale };
+	float hitTime;
+	vec2 normal;
+	return !TileSystem::raycastWall(origin, direction, 1.f, hitTime, normal);
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+// internal
+#include "common.hpp"
+
+// stlib
+#include <cstdint>
+#include <vector>
+
+// Line of sight between tiles for the enemy targeting, built once per level from the walls instead of looking through
+// the tile grid on every query. Per tile it keeps how many tiles can be seen in each of the four directions before a
+// wall, and a running count of the walls to rule out walls between two tiles at once. Tiles are (row, column).
+class Visibility
+{
+public:
+	// read the walls, on level load once the tiles are placed
+	static void build();
+	// a tile changed type, update the rows and columns that see through it
+	static void tileChanged(int row, int col);
+
+	// whether the tiles are at most range rows and range columns apart
+	static bool inRange(ivec2 from, ivec2 to, int range);
+	// whether a straight line between the centres of the tiles passes no wall
+	static bool canSee(ivec2 from, ivec2 to);
+
+private:
+	static int rowCount;
+	static int columnCount;
+	static std::vector<bool> walls;
+	// tiles without a wall next to each tile in each direction, up to the wall or the edge of the grid
+	static std::vector<uint16_t> clearLeft;
+	static std::vector<uint16_t> clearRight;
+	static std::vector<uint16_t> clearUp;
+	static std::vector<uint16_t> clearDown;
+	// walls in the rows above and the columns left of each corner, (rows + 1) x (columns + 1)
+	static std::vector<int> wallCounts;
+
+	static int index(int row, int col);
+	static void updateRow(int row);
+	static void updateColumn(int col);
+	static void updateWallCounts();
+	// walls in the rows and columns between the two corners, both included
+	static int wallsBetween(ivec2 from, ivec2 to);
+};
@@ -15,6 +15,8 @@
 #include "render.hpp"
 #include "render_components.hpp"
 #include "tiles/tiles.hpp"
+#include "crawl_graph.hpp"
+#include "visibility.hpp"
 #include "level_loader.hpp"
 #include "load_save.hpp"
 #include "controls_overlay.hpp"
@@ -232,7 +234,7 @@ void WorldSystem::step(float elapsed_ms, vec2 window_size_in_game_units)
 		auto projectilePosition = ECS::registry<Motion>.get(entity).position;
 		if (offScreen(projectilePosition, window_size_in_game_units, cameraOffset))
 		{
-			ECS::ContainerInterface::remove_all_components_of(entity);
+			ECS::commands().destroy(entity);
 		}
 	}
 
@@ -259,61 +261,64 @@ void WorldSystem::step(float elapsed_ms, vec2 window_size_in_game_units)
     assert(ECS::registry<ScreenState>.components.size() <= 1);
     auto& screen = ECS::registry<ScreenState>.components[0];
 
-    for (auto entity : ECS::registry<DeathTimer>.entities)
+    ECS::Entity expiredSnail = ECS::Entity::null();
+    ECS::view<DeathTimer, Snail, ShadedMeshRef, Motion>().each([&](ECS::Entity entity, DeathTimer& counter, Snail&, ShadedMeshRef& meshRef, Motion& mot)
     {
-        if(ECS::registry<Snail>.has(entity)) {
-            auto& texmesh = *ECS::registry<ShadedMeshRef>.get(entity).reference_to_cache;
-            texmesh.texture.color = {0.8, 0.2, 0.2};
-            
-            // Progress timer
-            auto& counter = ECS::registry<DeathTimer>.get(entity);
-            counter.counter_ms -= elapsed_ms;
-
-            // Reduce window brightness if any of the present snails is dying
-            screen.darken_screen_factor = 1 - counter.counter_ms / 500.f;
-
-            if(WaterTile::splashEntityID!=0) {
-                Motion& mot = ECS::registry<Motion>.get(entity);
-                auto mesh_ptr = ECS::registry<ShadedMeshRef>.get(entity).reference_to_cache;
-                float vol = mesh_ptr->mesh.original_size.x * mesh_ptr->mesh.original_size.x * ((mesh_ptr->mesh.original_size.x+mesh_ptr->mesh.original_size.y)/4);
-                float snailDensity = 0.23;
-                float mass = snailDensity * vol;
-                float drownedDist = ((vol - mass) * 9.81)*step_seconds;
-                mot.position.y += drownedDist;
-            }
-            // Restart the game once the death timer expired
-            if (counter.counter_ms < 0)
-            {
-                for (auto& waterEntity : ECS::registry<WaterTile>.entities)
-                {
-                    if (WaterTile::splashEntityID != waterEntity.id) {
-                        ECS::ContainerInterface::remove_all_components_of(waterEntity);
-                        ECS::registry<WaterTile>.remove(waterEntity);
-                    }
-                }
-                WaterTile::splashEntityID = 0;
-                ECS::registry<DeathTimer>.remove(entity);
-                restart(level);
-                return;
-            }
-        } else if (ECS::registry<Particle>.has(entity) || ECS::registry<Spider>.has(entity)){
-            auto& motion = ECS::registry<Motion>.get(entity);
-            bool isParticle = ECS::registry<Particle>.has(entity);
-            bool isWeatherParticle = ECS::registry<WeatherParticle>.has(entity) || ECS::registry<WeatherParentParticle>.has(entity);
-            if(isParticle || isWeatherParticle) {
-                motion.scale *= (isWeatherParticle) ? (1-(step_seconds/8)) : (1+(step_seconds/3));
-                motion.angle *= (isWeatherParticle) ? (1+(step_seconds)) : 1;
+        auto& texmesh = *meshRef.reference_to_cache;
+        texmesh.texture.color = {0.8, 0.2, 0.2};
+
+        // Progress timer
+        counter.counter_ms -= elapsed_ms;
+
+        // Reduce window brightness if any of the present snails is dying
+        screen.darken_screen_factor = 1 - counter.counter_ms / 500.f;
+
+        if(WaterTile::splashEntityID!=0) {
+            auto mesh_ptr = meshRef.reference_to_cache;
+            float vol = mesh_ptr->mesh.original_size.x * mesh_ptr->mesh.original_size.x * ((mesh_ptr->mesh.original_size.x+mesh_ptr->mesh.original_size.y)/4);
+            float snailDensity = 0.23;
+            float mass = snailDensity * vol;
+            float drownedDist = ((vol - mass) * 9.81)*step_seconds;
+            mot.position.y += drownedDist;
+        }
+        if (counter.counter_ms < 0)
+            expiredSnail = entity;
+    });
+
+    // Restart the game once the death timer expired
+    if (!expiredSnail.is_null())
+    {
+        for (auto& waterEntity : ECS::registry<WaterTile>.entities)
+        {
+            if (WaterTile::splashEntityID != waterEntity.id) {
+                ECS::ContainerInterface::remove_all_components_of(waterEntity);
+                ECS::registry<WaterTile>.remove(waterEntity);
             }
-            auto& counter = ECS::registry<DeathTimer>.get(entity);
-            counter.counter_ms -= elapsed_ms;
-            if (counter.counter_ms < 0)
-            {
-                if(!isWeatherParticle) {
-                    ECS::ContainerInterface::remove_all_components_of(entity);
-                }
+        }
+        WaterTile::splashEntityID = 0;
+        ECS::registry<DeathTimer>.remove(expiredSnail);
+        restart(level);
+        return;
+    }
+
+    ECS::view<DeathTimer, Motion>().each([&](ECS::Entity entity, DeathTimer& counter, Motion& motion)
+    {
+        bool isParticle = ECS::registry<Particle>.has(entity);
+        if (!isParticle && !ECS::registry<Spider>.has(entity))
+            return;
+        bool isWeatherParticle = ECS::registry<WeatherParticle>.has(entity) || ECS::registry<WeatherParentParticle>.has(entity);
+        if(isParticle || isWeatherParticle) {
+            motion.scale *= (isWeatherParticle) ? (1-(step_seconds/8)) : (1+(step_seconds/3));
+            motion.angle *= (isWeatherParticle) ? (1+(step_seconds)) : 1;
+        }
+        counter.counter_ms -= elapsed_ms;
+        if (counter.counter_ms < 0)
+        {
+            if(!isWeatherParticle) {
+                ECS::commands().destroy(entity);
             }
         }
-	}
+    });
 
 	if (turnType == PLAYER_WAITING)
     {
@@ -330,7 +335,7 @@ void WorldSystem::step(float elapsed_ms, vec2 window_size_in_game_units)
         }
 	    if (snail_move <= 0)
         {
-            for (auto& entity : ECS::registry<Fish>.entities) {
+            for (auto entity : ECS::registry<Fish>.entities) {
                 auto& move = ECS::registry<Fish::Move>.get(entity);
                 move.hasMoved = false;
             }
@@ -366,7 +371,7 @@ void WorldSystem::step(float elapsed_ms, vec2 window_size_in_game_units)
 	else if (turnType == ENEMY)
     {
         int move = 1;
-        for (auto& entity : ECS::registry<Fish>.entities) {
+        for (auto entity : ECS::registry<Fish>.entities) {
             fishMove(entity, move);
         }
 
@@ -517,95 +522,10 @@ void WorldSystem::onNotify(Event event) {
         }
     }
     
-    else if (event.type == Event::COLLISION) {
-
-        // Collisions involving snail
-        if (ECS::registry<Snail>.has(event.entity))
-        {
-            // Check collisions that result in death
-            if (ECS::registry<Enemy>.has(event.other_entity) || ECS::registry<WaterTile>.has(event.other_entity)
-                || ECS::registry<SlugProjectile>.has(event.other_entity))
-            {
-                // Initiate death unless already dying
-                if (!ECS::registry<DeathTimer>.has(event.entity))
-                {
-                    die();
-                }
-            }
-            else if (ECS::registry<Collectible>.has(event.other_entity))
-            {
-                int const id = ECS::registry<Collectible>.get(event.other_entity).id;
-                ECS::registry<Inventory>.components[0].collectibles.insert(id);
-                // Equip collectible (creates new entity)
-                Collectible::equip(event.entity, id);
-                Mix_PlayChannel(-1, collectible_sound, 0);
-                // Remove the collectible from the map
-                ECS::ContainerInterface::remove_all_components_of(event.other_entity);
-            }
-        }
-
-        // Collisions involving the snail projectiles
-        if (ECS::registry<SnailProjectile>.has(event.entity))
+    else if (event.type == Event::CONTACTS) {
+        for (const auto& contact : *event.contacts)
         {
-            // Don't collide with a preview projectile (ie. all enemies should fall under here)
-            if (!ECS::registry<SnailProjectile::Preview>.has(event.entity))
-            {
-                // Checking Projectile - Enemy / Enemy Projectile collisions
-                if (ECS::registry<Invincible>.has(event.other_entity))
-                {
-                    Mix_PlayChannel(-1, enemy_nope_sound, 0);
-                    // remove the projectile
-                    ECS::ContainerInterface::remove_all_components_of(event.entity);
-                }
-                else if (ECS::registry<Enemy>.has(event.other_entity))
-                {
-                    Mix_PlayChannel(-1, enemy_dead_sound, 0);
-
-                    // tile no longer occupied by enemy
-                    float scale = TileSystem::getScale();
-                    auto& motion = ECS::registry<Motion>.get(event.other_entity);
-                    int xCoord = static_cast<int>(motion.position.x / scale);
-                    int yCoord = static_cast<int>(motion.position.y / scale);
-                    Tile& t = TileSystem::getTiles()[yCoord][xCoord];
-                    t.removeOccupyingEntity();
-                    bool wasSpider = ECS::registry<Spider>.has(event.other_entity);
-                    enemies_killed++;
-                    ECS::Entity explodingSpider;
-                    if (wasSpider) {
-                        Spider::createExplodingSpider(motion, explodingSpider);
-                    }
-                    // Remove the enemy but not the projectile
-                    ECS::ContainerInterface::remove_all_components_of(event.other_entity);
-                }
-                else if (ECS::registry<SlugProjectile>.has(event.other_entity))
-                {
-                    Mix_PlayChannel(-1, projectile_break_sound, 0);
-                    // remove the enemy projectile
-                    ECS::ContainerInterface::remove_all_components_of(event.other_entity);
-                }
-            }
-        }
-        //spider to spider collision creates super spider
-        if (ECS::registry<Spider>.has(event.entity)) {
-            if (ECS::registry<Spider>.has(event.other_entity)) {
-                std::cout << "2 spiders in the same tile" << std::endl;
-                Mix_PlayChannel(-1, superspider_spawn_sound, 0);
-                float scale = TileSystem::getScale();
-                auto& motion1 = ECS::registry<Motion>.get(event.entity);
-                int xCoord = static_cast<int>(motion1.position.x / scale);
-                int yCoord = static_cast<int>(motion1.position.y / scale);
-                Tile& t = TileSystem::getTiles()[yCoord][xCoord];
-                // maybe I need 2 calls to remove both of them?
-                //t.removeOccupyingEntity();
-                ECS::Entity superSpider;
-                vec2 pos = { t.x, t.y };
-                t.removeOccupyingEntity();
-                t.removeOccupyingEntity();
-                ECS::ContainerInterface::remove_all_components_of(event.entity);
-                ECS::ContainerInterface::remove_all_components_of(event.other_entity);
-                SuperSpider::createSuperSpider(pos, superSpider);
-                t.addOccupyingEntity();
-            }
+            onContact(contact.entity, contact.other);
         }
     }
     else if (event.type == Event::LOAD_SAVE)
@@ -647,11 +567,6 @@ void WorldSystem::onNotify(Event event) {
             first_run = std::vector< std::vector< bool > >(tiles.size(), std::vector<bool>(tiles[0].size(), true));
         }
         
-    } else if (event.type == Event::SPLASH) {
-        if((event.entity.id != WaterTile::splashEntityID) && (ECS::registry<WaterTile>.has(event.entity))) {
-            Mix_PlayChannel(-1, splash_sound, 0);
-            WaterTile::onNotify(Event::SPLASH, event.entity);
-        }
     }
     else if (event.type == Event::PROJECTILE_POPPED)
     {
@@ -663,6 +578,124 @@ void WorldSystem::onNotify(Event event) {
     }
 }
 
+// a contact physics found this step, handled from both sides
+void WorldSystem::onContact(ECS::Entity entity, ECS::Entity other)
+{
+    // handling an earlier contact this step can start one dying
+    if (ECS::registry<DeathTimer>.has(entity) || ECS::registry<DeathTimer>.has(other))
+        return;
+
+    // touching water splashes, unless it's the splash itself
+    if (entity.id != WaterTile::splashEntityID && other.id != WaterTile::splashEntityID
+        && (ECS::registry<WaterTile>.has(entity) || ECS::registry<WaterTile>.has(other)))
+    {
+        ECS::Entity water = ECS::registry<WaterTile>.has(entity) ? entity : other;
+        Mix_PlayChannel(-1, splash_sound, 0);
+        WaterTile::onNotify(Event::SPLASH, water);
+        return;
+    }
+
+    onCollision(entity, other);
+    onCollision(other, entity);
+}
+
+// what happens to entity when it collides with other
+void WorldSystem::onCollision(ECS::Entity entity, ECS::Entity other)
+{
+    // Removals are deferred until physics finished iterating, ignore entities that already got removed
+    if (ECS::commands().is_pending_destroy(entity) || ECS::commands().is_pending_destroy(other))
+        return;
+
+    // Collisions involving snail
+    if (ECS::registry<Snail>.has(entity))
+    {
+        // Check collisions that result in death
+        if (ECS::registry<Enemy>.has(other) || ECS::registry<WaterTile>.has(other)
+            || ECS::registry<SlugProjectile>.has(other))
+        {
+            // Initiate death unless already dying
+            if (!ECS::registry<DeathTimer>.has(entity))
+            {
+                die();
+            }
+        }
+        else if (ECS::registry<Collectible>.has(other))
+        {
+            int const id = ECS::registry<Collectible>.get(other).id;
+            ECS::registry<Inventory>.components[0].collectibles.insert(id);
+            // Equip collectible (creates new entity)
+            Collectible::equip(entity, id);
+            Mix_PlayChannel(-1, collectible_sound, 0);
+            // Remove the collectible from the map
+            ECS::commands().destroy(other);
+        }
+    }
+
+    // Collisions involving the snail projectiles
+    if (ECS::registry<SnailProjectile>.has(entity))
+    {
+        // Don't collide with a preview projectile (ie. all enemies should fall under here)
+        if (!ECS::registry<SnailProjectile::Preview>.has(entity))
+        {
+            // Checking Projectile - Enemy / Enemy Projectile collisions
+            if (ECS::registry<Invincible>.has(other))
+            {
+                Mix_PlayChannel(-1, enemy_nope_sound, 0);
+                // remove the projectile
+                ECS::commands().destroy(entity);
+            }
+            else if (ECS::registry<Enemy>.has(other))
+            {
+                Mix_PlayChannel(-1, enemy_dead_sound, 0);
+
+                // tile no longer occupied by enemy
+                float scale = TileSystem::getScale();
+                auto& motion = ECS::registry<Motion>.get(other);
+                int xCoord = static_cast<int>(motion.position.x / scale);
+                int yCoord = static_cast<int>(motion.position.y / scale);
+                Tile& t = TileSystem::getTiles()[yCoord][xCoord];
+                t.removeOccupyingEntity();
+                bool wasSpider = ECS::registry<Spider>.has(other);
+                enemies_killed++;
+                ECS::Entity explodingSpider;
+                if (wasSpider) {
+                    Spider::createExplodingSpider(motion, explodingSpider);
+                }
+                // Remove the enemy but not the projectile
+                ECS::commands().destroy(other);
+            }
+            else if (ECS::registry<SlugProjectile>.has(other))
+            {
+                Mix_PlayChannel(-1, projectile_break_sound, 0);
+                // remove the enemy projectile
+                ECS::commands().destroy(other);
+            }
+        }
+    }
+    //spider to spider collision creates super spider
+    if (ECS::registry<Spider>.has(entity)) {
+        if (ECS::registry<Spider>.has(other)) {
+            std::cout << "2 spiders in the same tile" << std::endl;
+            Mix_PlayChannel(-1, superspider_spawn_sound, 0);
+            float scale = TileSystem::getScale();
+            auto& motion1 = ECS::registry<Motion>.get(entity);
+            int xCoord = static_cast<int>(motion1.position.x / scale);
+            int yCoord = static_cast<int>(motion1.position.y / scale);
+            Tile& t = TileSystem::getTiles()[yCoord][xCoord];
+            // maybe I need 2 calls to remove both of them?
+            //t.removeOccupyingEntity();
+            ECS::Entity superSpider;
+            vec2 pos = { t.x, t.y };
+            t.removeOccupyingEntity();
+            t.removeOccupyingEntity();
+            ECS::commands().destroy(entity);
+            ECS::commands().destroy(other);
+            SuperSpider::createSuperSpider(pos, superSpider);
+            t.addOccupyingEntity();
+        }
+    }
+}
+
 void WorldSystem::setFromJson(nlohmann::json const& saved)
 {
     level = saved[WorldKeys::LEVEL_NUM_KEY];
@@ -1591,6 +1624,9 @@ void WorldSystem::stepNPC()
         Motion& npcMotion = ECS::registry<Motion>.get(encountered_npc);
         float scale = TileSystem::getScale();
         TileSystem::getTiles()[npcMotion.position.y / scale][npcMotion.position.x / scale].type = EMPTY;
+        CrawlGraph::tileChanged(npcMotion.position.y / scale, npcMotion.position.x / scale);
+        Visibility::tileChanged(npcMotion.position.y / scale, npcMotion.position.x / scale);
+        TileSystem::gridChanged();
 
         // remove npc and its hat
         if (ECS::registry<Equipped>.has(encountered_npc))
@@ -99,10 +99,14 @@ private:
 	// kill the player :(
 	void die();
 
+	// collision handling
+	void onContact(ECS::Entity entity, ECS::Entity other);
+	void onCollision(ECS::Entity entity, ECS::Entity other);
+
 	// Game state
 	float current_speed;
-	ECS::Entity player_snail;
-	ECS::Entity encountered_npc;
+	ECS::Entity player_snail = ECS::Entity::null();
+	ECS::Entity encountered_npc = ECS::Entity::null();
 
 	// Stats (for end screen)
 	int deaths;